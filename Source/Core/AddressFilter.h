@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+#include "NonCopyable.h"
+
+// A counting bloom filter over memory block addresses.
+//
+// The hooked CRT `free()` is called for every heap block Telegram releases, from every thread,
+// while only a handful of blocks are ever of interest to us. This filter lets `OnFree` reject
+// the common case with two atomic loads, without taking any lock.
+//
+// `MayContain` never yields a false negative for an address that was `Add`ed and not yet
+// `Remove`d. False positives simply fall through to the locked slow path.
+//
+// `Add` and `Remove` must be paired and are expected to be called under the owner's lock.
+//
+class AddressFilter : NonCopyable, NonMovable
+{
+public:
+    AddressFilter() = default;
+
+    void Add(const void *Address)
+    {
+        const auto [First, Second] = Hash(Address);
+        _Counters[First].fetch_add(1, std::memory_order_release);
+        _Counters[Second].fetch_add(1, std::memory_order_release);
+    }
+
+    void Remove(const void *Address)
+    {
+        const auto [First, Second] = Hash(Address);
+        _Counters[First].fetch_sub(1, std::memory_order_release);
+        _Counters[Second].fetch_sub(1, std::memory_order_release);
+    }
+
+    bool MayContain(const void *Address) const
+    {
+        const auto [First, Second] = Hash(Address);
+        return _Counters[First].load(std::memory_order_acquire) != 0 &&
+               _Counters[Second].load(std::memory_order_acquire) != 0;
+    }
+
+private:
+    static constexpr uint32_t CounterBits = 14;
+    static constexpr uint32_t CounterCount = 1u << CounterBits;
+
+    std::array<std::atomic<uint16_t>, CounterCount> _Counters{};
+
+    static std::pair<uint32_t, uint32_t> Hash(const void *Address)
+    {
+        // Heap blocks are at least 8-byte aligned, the low bits carry no information.
+        //
+        uint64_t Value = (uint64_t)(uintptr_t)Address >> 3;
+
+        // Fibonacci hashing, then take two independent slices of the high bits.
+        //
+        Value *= 0x9E3779B97F4A7C15ull;
+
+        return {
+            (uint32_t)(Value >> (64 - CounterBits)),
+            (uint32_t)(Value >> (64 - CounterBits * 2)) & (CounterCount - 1)};
+    }
+};
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+#include <spdlog/fmt/fmt.h>
+
+// `dynamic_format_arg_store` moved out of the core header in fmt 8
+//
+#if FMT_VERSION >= 80000
+    #if defined SPDLOG_FMT_EXTERNAL
+        #include <fmt/args.h>
+    #else
+        #include <spdlog/fmt/bundled/args.h>
+    #endif
+#endif
+
+// The record format of deferred logging, see `Logger::Details::LogDeferred()`.
+//
+// The calling thread only encodes the arguments of a message next to the address of its format
+// string. The writer thread formats them into `ArLog.txt`, or with `TAR_BINARY_LOG` writes them
+// as they are into `ArLog.bin`, which `TAR-LogDecoder` turns back into text.
+//
+// `ArLog.bin` starts with `Magic`, followed by records. Each string (format, file or function) is
+// written once as a `StringHeaderT` record before the first message using it, messages refer to
+// it by id. All integers are little-endian.
+//
+namespace BinaryLog {
+
+constexpr char Magic[8] = {'T', 'A', 'R', 'L', 'O', 'G', '\0', '\1'};
+
+// The plugin only has one logger
+//
+constexpr char LoggerName[] = "Main";
+
+// Arguments not fitting are formatted on the calling thread
+//
+constexpr size_t MaxArgsSize = 480;
+
+enum class RecordType : uint8_t
+{
+    String,
+    Message,
+};
+
+enum class ArgType : uint8_t
+{
+    Bool,
+    Int,
+    UInt,
+    Float,
+    Double,
+    Pointer,
+    String, // Followed by an uint32_t size and the characters
+};
+
+#pragma pack(push, 1)
+struct StringHeaderT
+{
+    RecordType Type;
+    uint32_t Id;
+    uint32_t Size; // Followed by the characters
+};
+
+struct MessageHeaderT
+{
+    RecordType Type;
+    uint8_t Level;
+    uint32_t FormatId;
+    uint32_t FileId;
+    uint32_t FunctionId;
+    uint32_t Line;
+    uint32_t ThreadId;
+    int64_t Time; // Nanoseconds since the epoch of `spdlog::log_clock`
+    uint32_t ArgsSize; // Followed by the arguments
+};
+#pragma pack(pop)
+
+// Encodes arguments into a fixed buffer.
+//
+// Types without an encoding of their own are formatted with `{}` and encoded as strings.
+//
+class ArgWriter
+{
+public:
+    ArgWriter(std::byte *Buffer, size_t Capacity) : _Buffer{Buffer}, _Capacity{Capacity} {}
+
+    // Returns false if the argument doesn't fit, the buffer is then left incomplete.
+    //
+    template <class T>
+    bool Write(const T &Value)
+    {
+        using U = std::decay_t<T>;
+
+        if constexpr (std::is_same_v<U, bool>) {
+            return Put(ArgType::Bool, (uint8_t)Value);
+        }
+        else if constexpr (std::is_same_v<U, char>) {
+            return PutString(std::string_view{&Value, 1});
+        }
+        else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            return Put(ArgType::Int, (int64_t)Value);
+        }
+        else if constexpr (std::is_integral_v<U>) {
+            return Put(ArgType::UInt, (uint64_t)Value);
+        }
+        else if constexpr (std::is_same_v<U, float>) {
+            return Put(ArgType::Float, Value);
+        }
+        else if constexpr (std::is_floating_point_v<U>) {
+            return Put(ArgType::Double, (double)Value);
+        }
+        else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+            return PutString(std::string_view{Value});
+        }
+        else if constexpr (std::is_pointer_v<U>) {
+            return Put(ArgType::Pointer, (uint64_t)(uintptr_t)Value);
+        }
+        else {
+            return PutString(fmt::format("{}", Value));
+        }
+    }
+
+    bool WriteString(std::string_view Value)
+    {
+        return PutString(Value);
+    }
+
+    size_t GetSize() const
+    {
+        return _Size;
+    }
+
+private:
+    std::byte *_Buffer;
+    size_t _Capacity;
+    size_t _Size = 0;
+
+    bool Append(const void *Data, size_t Size)
+    {
+        if (_Capacity - _Size < Size) {
+            return false;
+        }
+        std::memcpy(_Buffer + _Size, Data, Size);
+        _Size += Size;
+        return true;
+    }
+
+    template <class T>
+    bool Put(ArgType Type, T Value)
+    {
+        return Append(&Type, sizeof(Type)) && Append(&Value, sizeof(Value));
+    }
+
+    bool PutString(std::string_view Value)
+    {
+        if (Value.size() > _Capacity) {
+            return false;
+        }
+        return Put(ArgType::String, (uint32_t)Value.size()) &&
+               Append(Value.data(), Value.size());
+    }
+};
+
+// Formats the encoded arguments with `Format`. Returns nothing if the arguments are malformed,
+// throws `fmt::format_error` if they don't match the format.
+//
+inline std::optional<std::string>
+FormatArgs(std::string_view Format, const std::byte *Args, size_t Size)
+{
+    fmt::dynamic_format_arg_store<fmt::format_context> Store;
+    size_t Position = 0;
+
+    auto Read = [&](void *Value, size_t ValueSize) {
+        if (Size - Position < ValueSize) {
+            return false;
+        }
+        std::memcpy(Value, Args + Position, ValueSize);
+        Position += ValueSize;
+        return true;
+    };
+
+    auto Push = [&](auto Value) {
+        if (!Read(&Value, sizeof(Value))) {
+            return false;
+        }
+        Store.push_back(Value);
+        return true;
+    };
+
+    while (Position < Size) {
+        ArgType Type;
+        Read(&Type, sizeof(Type));
+
+        bool Result;
+        switch (Type) {
+        case ArgType::Bool: {
+            uint8_t Value;
+            Result = Read(&Value, sizeof(Value));
+            Store.push_back(Value != 0);
+            break;
+        }
+        case ArgType::Int:
+            Result = Push(int64_t{});
+            break;
+        case ArgType::UInt:
+            Result = Push(uint64_t{});
+            break;
+        case ArgType::Float:
+            Result = Push(float{});
+            break;
+        case ArgType::Double:
+            Result = Push(double{});
+            break;
+        case ArgType::Pointer: {
+            uint64_t Value;
+            Result = Read(&Value, sizeof(Value));
+            Store.push_back((const void *)(uintptr_t)Value);
+            break;
+        }
+        case ArgType::String: {
+            uint32_t Length;
+            Result = Read(&Length, sizeof(Length)) && Size - Position >= Length;
+            if (Result) {
+                Store.push_back(std::string{(const char *)Args + Position, Length});
+                Position += Length;
+            }
+            break;
+        }
+        default:
+            Result = false;
+            break;
+        }
+
+        if (!Result) {
+            return std::nullopt;
+        }
+    }
+
+    return fmt::vformat(fmt::string_view{Format.data(), Format.size()}, Store);
+}
+
+} // namespace BinaryLog
@@ -1,12 +1,18 @@
 ﻿#include "IAntiRevoke.h"
 
 #include <unordered_map>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <chrono>
+#include <optional>
 
 #include <MinHook.h>
 
 #include "Logger.h"
 #include "IRuntime.h"
 #include "Utils.h"
+#include "ReadableMemory.h"
 
 IAntiRevoke &IAntiRevoke::GetInstance()
 {
@@ -78,6 +84,11 @@ void IAntiRevoke::InitMarker()
     //
     _MarkData = MultiLangMarks[L"en"].at(0);
 
+    if (!IRuntime::GetInstance().WaitLangInstance()) {
+        LOG(Warn, "[IAntiRevoke] Language instance unavailable, using the default marker.");
+        return;
+    }
+
     Safe::TryExcept(
         [&]() {
             LanguageInstance *pLangInstance =
@@ -148,96 +159,135 @@ void IAntiRevoke::SetupHooks()
 
 void IAntiRevoke::ProcessBlockedMessages()
 {
-    while (true) {
-        Sleep(1000);
-
-        std::lock_guard<std::mutex> Lock(_Mutex);
+    using Clock = std::chrono::steady_clock;
+    constexpr auto SweepInterval = std::chrono::seconds{1};
 
-        for (HistoryMessage *pMessage : _BlockedMessages) {
-            Safe::TryExcept(
-                [&]() {
-                    QtString *pTimeText = nullptr;
-                    HistoryMessageEdited *pEdited = pMessage->GetEdited();
-                    HistoryMessageSigned *pSigned = pMessage->GetSigned();
-
-                    // Signed msg take precedence over Edited msg, and TG uses the Signed text when
-                    // both exist.
-                    //
-                    if (pSigned != nullptr) {
-                        // Signed msg
-                        pTimeText = pSigned->GetTimeText();
-                    }
-                    else if (pEdited != nullptr) {
-                        // Edited msg
-                        pTimeText = pEdited->GetTimeText();
-                    }
-                    else {
-                        // Normal msg
-                        pTimeText = pMessage->GetTimeText();
-                    }
+    std::unique_lock<std::mutex> Lock(_Mutex);
+    auto NextSweep = Clock::now() + SweepInterval;
 
-                    //  vvvvvvvvvvvvvvvvvvvv TODO: This is a workaround, try to hook
-                    //  HistoryMessage's destructor to improve.
-                    if (pTimeText == nullptr ||
-                        pTimeText
-                            ->IsEmpty() || // This message content hasn't been cached by Telegram.
-                        pTimeText->Find(_MarkData.Content) !=
-                            std::wstring::npos /* This message is marked. */)
-                    {
-                        return;
-                    }
+    while (true) {
+        // Wake up as soon as a new message is blocked. Otherwise wake up periodically, to retry
+        // the messages whose content hasn't been cached by Telegram yet, and to re-mark the
+        // messages that Telegram has laid out again.
+        //
+        _Condition.wait_until(Lock, NextSweep, [this]() { return _HasNewMessages; });
+        _HasNewMessages = false;
+
+        // The sweep keeps its own deadline, new messages blocked more often than the interval
+        // would otherwise postpone it forever.
+        //
+        if (Clock::now() >= NextSweep) {
+            for (auto &[pMessage, Blocked] : _BlockedMessages) {
+                if (Blocked.State == MarkState::Marked && !IsMarked(pMessage, Blocked)) {
+                    Blocked.State = MarkState::Pending;
+                    _PendingMessages.insert(pMessage);
+                }
+            }
+            NextSweep = Clock::now() + SweepInterval;
+        }
 
-                    // Mark "deleted"
-                    //
+        MarkPendingMessages(Lock);
+    }
+}
 
-                    std::wstring MarkedTime;
+// Calls `Callback` on each item in a single guarded region. A faulting item is passed to
+// `FaultCallback`, then the rest is resumed in a new region.
+//
+template <class T, class CallbackT, class FaultCallbackT>
+static void ForEachGuarded(std::vector<T> &Items, CallbackT Callback, FaultCallbackT FaultCallback)
+{
+    size_t Next = 0;
+    while (Next < Items.size()) {
+        Safe::TryExcept(
+            [&]() {
+                for (; Next < Items.size(); ++Next) {
+                    Callback(Items[Next]);
+                }
+            },
+            [&](ULONG ExceptionCode) {
+                FaultCallback(Items[Next], ExceptionCode);
+                ++Next;
+            });
+    }
+}
 
-                    if (pSigned != nullptr) {
-                        // Signed msg text: "<author>, <time>" ("xxx, 10:20")
-                        //
-                        std::wstring OriginalString = pTimeText->GetText();
-                        size_t Pos = OriginalString.rfind(L", ");
-                        if (Pos == std::wstring::npos) {
-                            return;
-                        }
-
-                        MarkedTime = OriginalString.substr(0, Pos + 2) + _MarkData.Content +
-                                     OriginalString.substr(Pos + 2);
-                    }
-                    else {
-                        MarkedTime = _MarkData.Content + pTimeText->GetText();
-                    }
+void IAntiRevoke::MarkPendingMessages(std::unique_lock<std::mutex> &Lock)
+{
+    if (_PendingMessages.empty()) {
+        return;
+    }
 
-                    pTimeText->Replace(MarkedTime.c_str());
+    // A mass deletion revokes many messages of the same history at once, visit them together and
+    // in address order.
+    //
+    std::vector<MarkPlanT> Plans;
+    Plans.reserve(_PendingMessages.size());
+    for (HistoryMessage *pMessage : _PendingMessages) {
+        const auto &Blocked = _BlockedMessages.at(pMessage);
+        Plans.push_back({pMessage, Blocked.pHistory, Blocked.Serial, Blocked.State});
+    }
+    std::sort(Plans.begin(), Plans.end(), [](const MarkPlanT &Left, const MarkPlanT &Right) {
+        return std::tie(Left.pHistory, Left.pMessage) < std::tie(Right.pHistory, Right.pMessage);
+    });
 
-                    // Modify width
-                    //
+    // The read pass only reads Telegram's memory, so the hooks aren't held up by it. A message
+    // freed meanwhile is gone from `_BlockedMessages` by the commit pass, which skips it. One laid
+    // out again meanwhile is retried, see `CommitMark()`.
+    //
+    Lock.unlock();
+    ForEachGuarded(
+        Plans, [this](MarkPlanT &Plan) { PrepareMark(Plan); },
+        [](MarkPlanT &Plan, ULONG ExceptionCode) {
+            LOG(Warn,
+                "Function: [" __FUNCTION__ "] An exception was caught. Code: {:#x}, Address: {}",
+                ExceptionCode, (void *)Plan.pMessage);
+            Plan.Action = MarkAction::Drop;
+        });
+    Lock.lock();
 
-                    HistoryViewElement *pMainView = pMessage->GetMainView();
-                    if (pMainView == nullptr) {
-                        return;
-                    }
+    // A message that faults is dropped rather than retried on every pass, it would keep
+    // faulting the same way.
+    //
+    auto Drop = [this](HistoryMessage *pMessage) {
+        _BlockedMessages.erase(pMessage);
+        _PendingMessages.erase(pMessage);
+        _BlockedFilter.Remove(pMessage);
+    };
 
-                    pMainView->SetWidth(pMainView->GetWidth() + _MarkData.Width);
-                    pMessage->SetTimeWidth(pMessage->GetTimeWidth() + _MarkData.Width);
+    ForEachGuarded(
+        Plans,
+        [&](MarkPlanT &Plan) {
+            auto Iterator = _BlockedMessages.find(Plan.pMessage);
+            if (Iterator == _BlockedMessages.end() || Iterator->second.Serial != Plan.Serial) {
+                return;
+            }
 
-                    Media *pMainViewMedia = pMainView->GetMedia();
-                    if (pMainViewMedia != nullptr) {
-                        pMainViewMedia->SetWidth(pMainViewMedia->GetWidth() + _MarkData.Width);
-                    }
+            // Validated by the read pass, see `OnDestroyMessage()`
+            //
+            auto &Blocked = Iterator->second;
+            if (Plan.Action != MarkAction::Drop && Blocked.State == MarkState::Unvalidated) {
+                Blocked.State = MarkState::Pending;
+            }
 
-                    HistoryMessageReply *pReply = pMessage->GetReply();
-                    if (pReply != nullptr) {
-                        pReply->MaxReplyWidth() += _MarkData.Width;
-                    }
-                },
-                [&](ULONG ExceptionCode) {
-                    LOG(Warn,
-                        "Function: [" __FUNCTION__ "] An exception was caught. Code: {:#x}, Address: {}",
-                        ExceptionCode, (void *)pMessage);
-                });
-        }
-    }
+            switch (Plan.Action) {
+            case MarkAction::Retry:
+                break;
+            case MarkAction::Drop:
+                Drop(Plan.pMessage);
+                break;
+            default:
+                if (CommitMark(Plan, Blocked)) {
+                    _PendingMessages.erase(Plan.pMessage);
+                }
+                break;
+            }
+        },
+        [&](MarkPlanT &Plan, ULONG ExceptionCode) {
+            LOG(Warn,
+                "Function: [" __FUNCTION__ "] An exception was caught. Code: {:#x}, Address: {}",
+                ExceptionCode, (void *)Plan.pMessage);
+            Drop(Plan.pMessage);
+        });
 }
 
 void IAntiRevoke::CallFree(void *Block)
@@ -318,20 +368,260 @@ bool IAntiRevoke::HookRevokeFunction()
 #endif
 }
 
-void IAntiRevoke::OnFree(void *Block)
+static QtString *GetDisplayedTimeText(
+    HistoryMessage *pMessage, HistoryMessageEdited *pEdited, HistoryMessageSigned *pSigned)
 {
-    std::unique_lock<std::mutex> Lock(_Mutex);
+    // Signed msg take precedence over Edited msg, and TG uses the Signed text when both exist.
+    //
+    if (pSigned != nullptr) {
+        // Signed msg
+        return pSigned->GetTimeText();
+    }
+    else if (pEdited != nullptr) {
+        // Edited msg
+        return pEdited->GetTimeText();
+    }
+    else {
+        // Normal msg
+        return pMessage->GetTimeText();
+    }
+}
+
+// The mark goes right before the time. Returns nothing for a signed message whose text has no
+// author yet.
+//
+static std::optional<size_t> GetMarkPos(QtString *pTimeText, bool IsSigned)
+{
+    if (!IsSigned) {
+        return 0;
+    }
+
+    // Signed msg text: "<author>, <time>" ("xxx, 10:20")
+    //
+    size_t Pos = pTimeText->GetView().rfind(L", ");
+    if (Pos == std::wstring_view::npos) {
+        return std::nullopt;
+    }
+    return Pos + 2;
+}
+
+bool IAntiRevoke::IsMarked(HistoryMessage *pMessage, const BlockedMessageT &Blocked)
+{
+    bool Result = true;
+
+    Safe::TryExcept(
+        [&]() {
+            auto Components = pMessage->GetComponents();
+            QtString *pTimeText =
+                GetDisplayedTimeText(pMessage, Components.pEdited, Components.pSigned);
+
+            if (pTimeText == nullptr) {
+                return;
+            }
+
+            // Telegram replaces the whole string when it lays out the message again, so the data
+            // we installed is only still there while the message is marked. Once freed, its
+            // address may be reused for a new unmarked text, so the mark has to be there too.
+            //
+            const auto MarkPos = GetMarkPos(pTimeText, Components.pSigned != nullptr);
+            Result = pTimeText->GetData() == Blocked.pMarkedData && MarkPos.has_value() &&
+                     pTimeText->StartsWith(_MarkData.Content, MarkPos.value());
+        },
+        [&](ULONG ExceptionCode) {
+            LOG(Warn,
+                "Function: [" __FUNCTION__ "] An exception was caught. Code: {:#x}, Address: {}",
+                ExceptionCode, (void *)pMessage);
+        });
+
+    return Result;
+}
+
+void IAntiRevoke::PrepareMark(MarkPlanT &Plan)
+{
+    HistoryMessage *pMessage = Plan.pMessage;
+
+    if (Plan.State == MarkState::Unvalidated && !IsValidMessage(pMessage)) {
+        Plan.Action = MarkAction::Drop;
+        return;
+    }
+
+    auto Components = pMessage->GetComponents();
+    HistoryMessageSigned *pSigned = Components.pSigned;
+    QtString *pTimeText = GetDisplayedTimeText(pMessage, Components.pEdited, pSigned);
+
+    //  vvvvvvvvvvvvvvvvvvvv TODO: This is a workaround, try to hook
+    //  HistoryMessage's destructor to improve.
+    if (pTimeText == nullptr ||
+        pTimeText->IsEmpty() /* This message content hasn't been cached by Telegram. */)
+    {
+        Plan.Action = MarkAction::Retry;
+        return;
+    }
+
+    const auto MarkPos = GetMarkPos(pTimeText, pSigned != nullptr);
+    if (!MarkPos.has_value()) {
+        Plan.Action = MarkAction::Retry;
+        return;
+    }
+
+    std::wstring_view OriginalText = pTimeText->GetView();
+    Plan.pTimeText = pTimeText;
+    Plan.pOriginalData = pTimeText->GetData();
+
+    if (pTimeText->StartsWith(_MarkData.Content, MarkPos.value())) {
+        // This message is marked.
+        Plan.Action = MarkAction::Adopt;
+        return;
+    }
+
+    Plan.MarkedTime.reserve(OriginalText.size() + _MarkData.Content.size());
+    Plan.MarkedTime.append(OriginalText.substr(0, MarkPos.value()))
+        .append(_MarkData.Content)
+        .append(OriginalText.substr(MarkPos.value()));
+
+    Plan.pMainView = pMessage->GetMainView();
+    if (Plan.pMainView != nullptr) {
+        Plan.pMainViewMedia = Plan.pMainView->GetMedia();
+    }
+    Plan.pReply = Components.pReply;
+    Plan.Action = MarkAction::Mark;
+}
+
+bool IAntiRevoke::CommitMark(const MarkPlanT &Plan, BlockedMessageT &Blocked)
+{
+    // Telegram may have laid the message out again since the read pass, rebuilding the objects
+    // written below while leaving the time text as it was. Everything the read pass found is read
+    // again, and the message is retried if anything changed.
+    //
+    auto Components = Plan.pMessage->GetComponents();
+    if (GetDisplayedTimeText(Plan.pMessage, Components.pEdited, Components.pSigned) !=
+            Plan.pTimeText ||
+        Plan.pTimeText->GetData() != Plan.pOriginalData)
+    {
+        return false;
+    }
+
+    if (Plan.Action == MarkAction::Adopt) {
+        Blocked.State = MarkState::Marked;
+        Blocked.pMarkedData = Plan.pOriginalData;
+        return true;
+    }
+
+    HistoryViewElement *pMainView = Plan.pMessage->GetMainView();
+    Media *pMainViewMedia = pMainView != nullptr ? pMainView->GetMedia() : nullptr;
+    if (pMainView != Plan.pMainView || pMainViewMedia != Plan.pMainViewMedia ||
+        Components.pReply != Plan.pReply)
+    {
+        return false;
+    }
+
+    Blocked.State = MarkState::Marked;
+
+    // Mark "deleted"
+    //
+    Plan.pTimeText->Assign(GetMarkedText(Plan.MarkedTime));
+    Blocked.pMarkedData = Plan.pTimeText->GetData();
+
+    // Modify width
+    //
+    if (Plan.pMainView == nullptr) {
+        return true;
+    }
+
+    Plan.pMainView->SetWidth(Plan.pMainView->GetWidth() + _MarkData.Width);
+    Plan.pMessage->SetTimeWidth(Plan.pMessage->GetTimeWidth() + _MarkData.Width);
+
+    if (Plan.pMainViewMedia != nullptr) {
+        Plan.pMainViewMedia->SetWidth(Plan.pMainViewMedia->GetWidth() + _MarkData.Width);
+    }
+
+    if (Plan.pReply != nullptr) {
+        Plan.pReply->MaxReplyWidth() += _MarkData.Width;
+    }
+
+    return true;
+}
+
+QtArrayData *IAntiRevoke::GetMarkedText(const std::wstring &Text)
+{
+    // Messages sent in the same minute get the same text, so they share a single Qt string
+    // instead of each allocating one. The pool holds a reference to each of them, so Telegram
+    // never frees one while it's still here.
+    //
+    constexpr size_t MaxMarkedTexts = 1024;
+
+    if (auto Iterator = _MarkedTexts.find(Text); Iterator != _MarkedTexts.end()) {
+        return Iterator->second;
+    }
+
+    // The messages hold their own references, dropping ours only frees the unused texts
+    //
+    if (_MarkedTexts.size() >= MaxMarkedTexts) {
+        for (const auto &[String, pData] : _MarkedTexts) {
+            QtString::Release(pData);
+        }
+        _MarkedTexts.clear();
+    }
 
+    QtString NewText(Text.c_str());
+    return _MarkedTexts.emplace(Text, NewText.GetData()).first->second;
+}
+
+void IAntiRevoke::OnFree(void *Block)
+{
     // When we delete a msg by ourselves, Telegram will free this memory block.
-    // So, we need to earse this msg from the vector.
+    // So, we need to earse this msg from the set.
+    //
+    // Nearly every block freed here is not a blocked message, so reject those without locking.
     //
 
-    _BlockedMessages.erase((HistoryMessage *)Block);
-    Lock.unlock();
+    if (_BlockedFilter.MayContain(Block)) {
+        std::lock_guard<std::mutex> Lock(_Mutex);
+
+        if (_BlockedMessages.erase((HistoryMessage *)Block) != 0) {
+            _PendingMessages.erase((HistoryMessage *)Block);
+            _BlockedFilter.Remove(Block);
+        }
+    }
 
     CallFree(Block);
 }
 
+bool IAntiRevoke::IsValidMessage(HistoryMessage *pMessage)
+{
+    if (!ReadableMemory::GetInstance().IsReadable(pMessage, sizeof(void *)) ||
+        !pMessage->IsMessage())
+    {
+        return false;
+    }
+
+    QtString *pTimeText = pMessage->GetTimeText();
+    if (!pTimeText->IsValidTime()) {
+        LOG(Warn, "A bad TimeText. Address: {}", (void *)pMessage);
+        return false;
+    }
+
+    return true;
+}
+
+void IAntiRevoke::BlockMessage(History *pHistory, HistoryMessage *pMessage, MarkState State)
+{
+    {
+        std::lock_guard<std::mutex> Lock(_Mutex);
+        auto [Iterator, IsInserted] = _BlockedMessages.try_emplace(pMessage);
+        if (!IsInserted) {
+            return;
+        }
+        Iterator->second.Serial = _NextSerial++;
+        Iterator->second.State = State;
+        Iterator->second.pHistory = pHistory;
+        _PendingMessages.insert(pMessage);
+        _BlockedFilter.Add(pMessage);
+        _HasNewMessages = true;
+    }
+    _Condition.notify_one();
+}
+
 void IAntiRevoke::OnDestroyMessage(History *pHistory, HistoryMessage *pMessage)
 {
     Safe::TryExcept(
@@ -339,20 +629,23 @@ void IAntiRevoke::OnDestroyMessage(History *pHistory, HistoryMessage *pMessage)
             // TODO: Allow revoking BOT messages in non-private chats.
             //
 
-            if (!pMessage->IsMessage()) {
+            // The hook goes live before the index `IsMessage()` depends on is resolved. Rather
+            // than holding Telegram's UI thread until it is, the messages revoked meanwhile are
+            // validated by the worker, which starts once it is resolved.
+            //
+            if (IRuntime::GetInstance().GetLayout() == nullptr) {
+                LOG(Debug, "Caught a deleted meesage before the layout. Address: {}",
+                    (void *)pMessage);
+                BlockMessage(pHistory, pMessage, MarkState::Unvalidated);
                 return;
             }
 
-            QtString *pTimeText = pMessage->GetTimeText();
-            if (!pTimeText->IsValidTime()) {
-                LOG(Warn, "A bad TimeText. Address: {}", (void *)pMessage);
+            if (!IsValidMessage(pMessage)) {
                 return;
             }
 
             LOG(Debug, "Caught a deleted meesage. Address: {}", (void *)pMessage);
-
-            std::lock_guard<std::mutex> Lock(_Mutex);
-            _BlockedMessages.insert(pMessage);
+            BlockMessage(pHistory, pMessage, MarkState::Pending);
         },
         [&](ULONG ExceptionCode) {
             LOG(Warn, "Function: [" __FUNCTION__ "] An exception was caught. Code: {:#x}",
@@ -1,10 +1,13 @@
 ﻿#pragma once
 
 #include <unordered_set>
+#include <unordered_map>
 #include <mutex>
+#include <condition_variable>
 
 #include "Telegram.h"
 #include "IRuntime.h"
+#include "AddressFilter.h"
 
 using FnDestroyMessageT = void(__thiscall *)(History *pHistory, HistoryMessage *pMessage);
 
@@ -27,15 +30,79 @@ private:
         int32_t Width;
     };
 
+    enum class MarkState : uint8_t
+    {
+        Unvalidated, // Revoked before the layout was resolved, not known to be a message yet.
+        Pending,     // Not marked yet, its content hasn't been cached by Telegram, or Telegram
+                     // has replaced the text we installed.
+        Marked       // Marked by us, and `pMarkedData` is still installed.
+    };
+
+    struct BlockedMessageT
+    {
+        MarkState State = MarkState::Pending;
+        QtArrayData *pMarkedData = nullptr; // The text data we installed
+        History *pHistory = nullptr;        // The history the message was revoked from
+        uint32_t Serial = 0;                // Tells apart messages allocated at the same address
+    };
+
+    enum class MarkAction : uint8_t
+    {
+        Retry, // Its content hasn't been cached by Telegram yet.
+        Drop,  // Not a message, or it faulted.
+        Adopt, // Already marked, e.g. it shares a marked text.
+        Mark
+    };
+
+    // What the read pass of `MarkPendingMessages()` found out about a message, applied by the
+    // commit pass.
+    //
+    struct MarkPlanT
+    {
+        HistoryMessage *pMessage;
+        History *pHistory;
+        uint32_t Serial;
+        MarkState State;
+        MarkAction Action = MarkAction::Retry;
+        QtString *pTimeText = nullptr;
+        QtArrayData *pOriginalData = nullptr;
+        std::wstring MarkedTime;
+        HistoryViewElement *pMainView = nullptr;
+        Media *pMainViewMedia = nullptr;
+        HistoryMessageReply *pReply = nullptr;
+    };
+
     MarkDataT _MarkData;
     FnDestroyMessageT _FnOriginalDestroyMessage;
     FnFreeT _FnOriginalFree;
     std::mutex _Mutex;
-    std::unordered_set<HistoryMessage *> _BlockedMessages;
+    std::condition_variable _Condition;
+    bool _HasNewMessages = false;
+    uint32_t _NextSerial = 0;
+    std::unordered_map<HistoryMessage *, BlockedMessageT> _BlockedMessages;
+    std::unordered_set<HistoryMessage *> _PendingMessages;
+    std::unordered_map<std::wstring, QtArrayData *> _MarkedTexts; // Shared by marked messages
+    AddressFilter _BlockedFilter;
 
     bool HookFreeFunction();
     bool HookRevokeFunction();
 
+    void BlockMessage(History *pHistory, HistoryMessage *pMessage, MarkState State);
+
+    // Not guarded, and only usable once the layout is resolved.
+    //
+    bool IsValidMessage(HistoryMessage *pMessage);
+
+    bool IsMarked(HistoryMessage *pMessage, const BlockedMessageT &Blocked);
+    void MarkPendingMessages(std::unique_lock<std::mutex> &Lock);
+
+    // Not guarded, see `MarkPendingMessages()`. `CommitMark()` returns false if the message has
+    // to be read again.
+    //
+    void PrepareMark(MarkPlanT &Plan);
+    bool CommitMark(const MarkPlanT &Plan, BlockedMessageT &Blocked);
+    QtArrayData *GetMarkedText(const std::wstring &Text);
+
     void OnFree(void *Block);
     void OnDestroyMessage(History *pHistory, HistoryMessage *pMessage);
 
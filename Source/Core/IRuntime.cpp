@@ -1,7 +1,24 @@
 #include "IRuntime.h"
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <fstream>
+#include <cstring>
+#include <iterator>
+
+#include <nlohmann/json.hpp>
+
 #include "Logger.h"
+#include "Config.h"
 #include "Utils.h"
+#include "Signatures.h"
+#include "Layouts.h"
+
+#pragma comment(lib, "Psapi.lib")
+
+using json = nlohmann::json;
 
 IRuntime &IRuntime::GetInstance()
 {
@@ -11,126 +28,149 @@ IRuntime &IRuntime::GetInstance()
 
 bool IRuntime::Initialize()
 {
-    _MainModule = _ThisProcess.in_module(
-        "Telegram.exe", sigmatch::mem_prot::read | sigmatch::mem_prot::execute);
-    if (_MainModule.error().has_value()) {
-        LOG(Warn, "[IRuntime] _MainModule.error().value(): {}", _MainModule.error().value());
+    HMODULE hMainModule = GetModuleHandleA("Telegram.exe");
+    if (hMainModule == nullptr) {
+        LOG(Warn, "[IRuntime] GetModuleHandleA() failed. LastError: {}", ::GetLastError());
         return false;
     }
 
-    _FileVersion = File::GetCurrentVersion();
-    if (_FileVersion == 0) {
-        LOG(Warn, "[IRuntime] _FileVersion == 0");
+    MODULEINFO ModuleInfo;
+    if (!GetModuleInformation(GetCurrentProcess(), hMainModule, &ModuleInfo, sizeof(ModuleInfo))) {
+        LOG(Warn, "[IRuntime] GetModuleInformation() failed. LastError: {}", ::GetLastError());
         return false;
     }
 
-    LOG(Info, "[IRuntime] Telegram version: {}", _FileVersion);
-    return true;
+    return Initialize(
+        (const std::byte *)ModuleInfo.lpBaseOfDll, ModuleInfo.SizeOfImage,
+        File::GetCurrentVersion());
 }
 
-bool IRuntime::InitFixedData()
+bool IRuntime::Initialize(const std::byte *ModuleBase, size_t ModuleSize, uint32_t FileVersion)
 {
-#if defined PLATFORM_X86
-
-    // ver < 2.4.0
-    if (_FileVersion < 2004000) {
+    if (FileVersion == 0) {
+        LOG(Warn, "[IRuntime] _FileVersion == 0");
         return false;
     }
-    // ver >= 2.4.0, ver < 2.4.1
-    else if (_FileVersion >= 2004000 && _FileVersion < 2004001) {
-        _Data.Offset.TimeText = 0x70;
-        _Data.Offset.TimeWidth = 0x74;
-        _Data.Offset.MainView = 0x5C;
-        // _Data.Offset.Media = 0x54;
-        _Data.Offset.SignedTimeText = 0x14;
-        // _Data.Offset.HistoryPeer = 0x7C;
-        _Data.Offset.MaxReplyWidth = 0x6C;
-    }
-    // ver >= 2.4.1, ver < 2.6.0
-    else if (_FileVersion >= 2004001 && _FileVersion < 2006000) {
-        _Data.Offset.TimeText = 0x70;
-        _Data.Offset.TimeWidth = 0x74;
-        _Data.Offset.MainView = 0x5C;
-        // _Data.Offset.Media = 0x54;
-        _Data.Offset.SignedTimeText = 0x10; // changed
-        // _Data.Offset.HistoryPeer = 0x7C;       // maybe untested! (I forgot :)
-        _Data.Offset.MaxReplyWidth = 0x6C;
+
+    _ModuleBase = ModuleBase;
+    _ModuleSize = ModuleSize;
+    _FileVersion = FileVersion;
+
+    auto Image = PeImage::Parse(_ModuleBase, _ModuleSize, PeImage::Layout::Mapped);
+    if (!Image.has_value()) {
+        LOG(Warn, "[IRuntime] Failed to parse the PE headers of the main module.");
+        return false;
     }
-    // ver >= 2.6.0, ver < 2.9.0
-    else if (_FileVersion >= 2006000 && _FileVersion < 2009000) {
-        _Data.Offset.TimeText = 0x78;  // changed
-        _Data.Offset.TimeWidth = 0x7C; // changed
-        _Data.Offset.MainView = 0x60;  // changed
-        // _Data.Offset.Media = 0x5C;             // changed
-        _Data.Offset.SignedTimeText = 0x10;
-        // _Data.Offset.HistoryPeer = 0x7C;       // untested!
-        _Data.Offset.MaxReplyWidth = 0x6C;
+    _Image = std::move(Image.value());
+
+    // Signatures only match compiled code, so only `.text` is scanned. Fall back to every
+    // executable section if the linker named things differently.
+    //
+    if (auto pText = _Image.FindSection(".text"); pText != nullptr) {
+        _CodeRegions.push_back({_Image.GetSectionBegin(*pText), _Image.GetSectionSize(*pText)});
     }
-    // ver >= 2.9.0, ver < 3.1.7
-    else if (_FileVersion >= 2009000 && _FileVersion < 3001007) {
-        _Data.Offset.TimeText = 0x70;  // changed
-        _Data.Offset.TimeWidth = 0x74; // changed
-        _Data.Offset.MainView = 0x5C;  // changed
-        _Data.Offset.SignedTimeText = 0x10;
-        _Data.Offset.MaxReplyWidth = 0x6C;
+    else {
+        for (const auto &Section : _Image.GetSections()) {
+            if ((Section.Characteristics & PeImage::SectionExecute) != 0) {
+                _CodeRegions.push_back(
+                    {_Image.GetSectionBegin(Section), _Image.GetSectionSize(Section)});
+            }
+        }
     }
-    // ver >= 3.1.7
-    else if (_FileVersion >= 3001007) {
-        _Data.Offset.TimeText = 0x78;  // changed
-        _Data.Offset.TimeWidth = 0x7C; // changed
-        _Data.Offset.MainView = 0x64;  // changed
-        _Data.Offset.SignedTimeText = 0x10;
-        _Data.Offset.MaxReplyWidth = 0x74; // changed
+
+    if (_CodeRegions.empty()) {
+        LOG(Warn, "[IRuntime] No code section found in the main module.");
+        return false;
     }
 
+    LOG(Info, "[IRuntime] Telegram version: {}", _FileVersion);
     return true;
+}
 
-#elif defined PLATFORM_X64
-
-    _Data.Offset.TimeText = 0xB0;
-    _Data.Offset.TimeWidth = 0xB8;
-    _Data.Offset.MainView = 0x98;
-    _Data.Offset.SignedTimeText = 0x18;
+// Entries of the override file are added to the embedded layouts, replacing those with the same
+// `MinVersion`. Each entry must specify every field:
+//
+//     { "x64": [ { "min_version": 4000000, "time_text": 176, ... } ] }
+//
+constexpr auto LayoutsFileName = "TAR-Layouts.json";
 
-    // ver < 3.1.8
-    if (_FileVersion < 3001008) {
-        _Data.Offset.MaxReplyWidth = 0xA4;
+static std::vector<Layouts::EntryT> LoadLayouts()
+{
+    std::vector<Layouts::EntryT> Result(std::begin(Layouts::Embedded), std::end(Layouts::Embedded));
+
+    try {
+        std::ifstream File{LayoutsFileName};
+        if (File.good()) {
+            json Root;
+            File >> Root;
+
+            for (const auto &Object : Root[AR_PLATFORM_STR]) {
+                Layouts::EntryT Entry;
+                Entry.MinVersion = Object.at("min_version").get<uint32_t>();
+                for (const auto &[Name, pValue] : Layouts::GetFields(Entry.Offset)) {
+                    *pValue = Object.at(Name).get<uint32_t>();
+                }
+
+                std::erase_if(Result, [&](const Layouts::EntryT &Existing) {
+                    return Existing.MinVersion == Entry.MinVersion;
+                });
+                Result.push_back(Entry);
+
+                LOG(Info, "[IRuntime] Layout of version {} overridden.", Entry.MinVersion);
+            }
+        }
     }
-    // ver >= 3.1.8
-    else if (_FileVersion >= 3001008) {
-        _Data.Offset.MaxReplyWidth = 0xAC;
+    catch (json::exception &Exception) {
+        LOG(Warn, "[IRuntime] Caught a json exception while loading layouts, ignored. What: {}",
+            Exception.what());
+        Result.assign(std::begin(Layouts::Embedded), std::end(Layouts::Embedded));
     }
 
-    return true;
+    std::sort(Result.begin(), Result.end(), [](const auto &Left, const auto &Right) {
+        return Left.MinVersion < Right.MinVersion;
+    });
+    return Result;
+}
 
-#else
-    #error "Unimplemented."
-#endif
+bool IRuntime::InitFixedData()
+{
+    const auto AllLayouts = LoadLayouts();
+
+    auto pEntry = Layouts::FindEntry(
+        AllLayouts.data(), AllLayouts.data() + AllLayouts.size(), _FileVersion);
+    if (pEntry == nullptr) {
+        return false;
+    }
+
+    _Data.Offset = pEntry->Offset;
+
+    LOG(Info, "[IRuntime] Using the layout of version {}.", pEntry->MinVersion);
+    return true;
 }
 
 bool IRuntime::InitDynamicData()
 {
-    bool Result = false;
+    bool Result = false, IsCached = false;
 
     Safe::TryExcept(
         [&]() {
-#define INIT_DATA_AND_LOG(name)                                                                    \
-    if (!InitDynamicData_##name()) {                                                               \
-        LOG(Warn, "[IRuntime] InitDynamicData_" #name "() failed.");                               \
-        return;                                                                                    \
-    }                                                                                              \
-    else {                                                                                         \
-        LOG(Info, "[IRuntime] InitDynamicData_" #name "() succeeded.");                            \
-    }
-            INIT_DATA_AND_LOG(MallocFree);
-            INIT_DATA_AND_LOG(DestroyMessage);
-            INIT_DATA_AND_LOG(EditedIndex);
-            INIT_DATA_AND_LOG(SignedIndex);
-            INIT_DATA_AND_LOG(ReplyIndex);
-            INIT_DATA_AND_LOG(LangInstance);
-            INIT_DATA_AND_LOG(IsMessage);
-
-#undef INIT_DATA_AND_LOG
+            // The hooks patch `Function.Free` and the caller of the destroy function, so the
+            // code is hashed and the cached bytes are taken before they go live
+            //
+            _CodeHash = HashCode();
+
+            if (LoadCache()) {
+                LOG(Info, "[IRuntime] Resolved data loaded from cache.");
+                IsCached = true;
+            }
+            else if (!ResolveCriticalData()) {
+                return;
+            }
+
+            if (!IsCached) {
+                TakeCodeSnapshots();
+            }
+
             Result = true;
         },
         [&](uint32_t ExceptionCode) {
@@ -138,7 +178,373 @@ bool IRuntime::InitDynamicData()
                 ExceptionCode);
         });
 
-    return Result;
+    if (!Result) {
+        return false;
+    }
+
+    // The hooks only need the critical data, so everything else is resolved in the background
+    // while they go live. Readers wait for it through `WaitDeferredData()`.
+    //
+    auto ResolveDeferred = [this, IsCached]() {
+        bool Result = IsCached;
+        if (!IsCached) {
+            Safe::TryExcept(
+                [&]() { Result = ResolveDeferredData(); },
+                [&](uint32_t ExceptionCode) {
+                    LOG(Warn, "[IRuntime] ResolveDeferredData() caught an exception, code: {:#x}",
+                        ExceptionCode);
+                });
+
+            if (Result) {
+                TakeCodeSnapshots();
+                SaveCache();
+            }
+        }
+
+        if (Result) {
+            Result = false;
+            Safe::TryExcept(
+                [&]() { Result = ResolveComponentIndices(); },
+                [&](uint32_t ExceptionCode) {
+                    LOG(Warn,
+                        "[IRuntime] ResolveComponentIndices() caught an exception, code: {:#x}",
+                        ExceptionCode);
+                });
+        }
+
+        if (Result) {
+            PublishLayout();
+        }
+        return Result;
+    };
+
+    // Telegram creates the instance late in its startup, this may take seconds
+    //
+    auto ResolveLang = [this]() {
+        if (!WaitDeferredData()) {
+            return false;
+        }
+
+        bool Result = false;
+        Safe::TryExcept(
+            [&]() { Result = ResolveLangInstance(); },
+            [&](uint32_t ExceptionCode) {
+                LOG(Warn, "[IRuntime] ResolveLangInstance() caught an exception, code: {:#x}",
+                    ExceptionCode);
+            });
+        return Result;
+    };
+
+    _DeferredData = std::async(std::launch::async, ResolveDeferred).share();
+    _LangInstance = std::async(std::launch::async, ResolveLang).share();
+
+    return true;
+}
+
+bool IRuntime::WaitDeferredData() const
+{
+    return _DeferredData.valid() && _DeferredData.get();
+}
+
+bool IRuntime::WaitLangInstance() const
+{
+    return _LangInstance.valid() && _LangInstance.get();
+}
+
+bool IRuntime::ResolveDynamicData()
+{
+    _Timings.clear();
+    return ResolveCriticalData() && ResolveDeferredData();
+}
+
+bool IRuntime::ResolveCriticalData()
+{
+    return RunStep("ScanSignatures(Critical)", &IRuntime::ScanCriticalSignatures) &&
+           RunStep("InitDynamicData_MallocFree", &IRuntime::InitDynamicData_MallocFree) &&
+           RunStep("InitDynamicData_DestroyMessage", &IRuntime::InitDynamicData_DestroyMessage);
+}
+
+bool IRuntime::ResolveDeferredData()
+{
+    return RunStep("ScanSignatures(Deferred)", &IRuntime::ScanDeferredSignatures) &&
+           RunStep("InitDynamicData_EditedIndex", &IRuntime::InitDynamicData_EditedIndex) &&
+           RunStep("InitDynamicData_SignedIndex", &IRuntime::InitDynamicData_SignedIndex) &&
+           RunStep("InitDynamicData_ReplyIndex", &IRuntime::InitDynamicData_ReplyIndex) &&
+           RunStep("InitDynamicData_LangInstance", &IRuntime::InitDynamicData_LangInstance) &&
+           RunStep("InitDynamicData_IsMessage", &IRuntime::InitDynamicData_IsMessage);
+}
+
+bool IRuntime::ResolveComponentIndices()
+{
+    // Telegram assigns each index on the first call and never changes it, so call them once here
+    // instead of on every component lookup
+    //
+    _Data.ComponentIndex.Edited = (uint32_t)_Data.Function.EditedIndex();
+    _Data.ComponentIndex.Signed = (uint32_t)_Data.Function.SignedIndex();
+    _Data.ComponentIndex.Reply = (uint32_t)_Data.Function.ReplyIndex();
+
+    // `RuntimeComposerMetadata` holds at most 64 components
+    //
+    const auto &Index = _Data.ComponentIndex;
+    if (Index.Edited >= 64 || Index.Signed >= 64 || Index.Reply >= 64) {
+        LOG(Warn, "[IRuntime] Invalid component index. Edited: {}, Signed: {}, Reply: {}",
+            Index.Edited, Index.Signed, Index.Reply);
+        return false;
+    }
+
+    LOG(Info, "[IRuntime] Component index. Edited: {}, Signed: {}, Reply: {}", Index.Edited,
+        Index.Signed, Index.Reply);
+    return true;
+}
+
+void IRuntime::PublishLayout()
+{
+    _Layout.Offset = _Data.Offset;
+    _Layout.Index = _Data.Index;
+    _Layout.ComponentIndex = _Data.ComponentIndex;
+    _Layout.FnIsMessage = ResolvedLayout::SelectIsMessage(_FileVersion);
+
+    ResolvedLayout::Publish(&_Layout);
+}
+
+bool IRuntime::RunStep(const char *Name, bool (IRuntime::*Step)())
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto Begin = Clock::now();
+    if (!(this->*Step)()) {
+        LOG(Warn, "[IRuntime] {}() failed.", Name);
+        return false;
+    }
+
+    _Timings.push_back({Name, Clock::now() - Begin});
+    LOG(Info, "[IRuntime] {}() succeeded.", Name);
+    return true;
+}
+
+bool IRuntime::IsInDataSections(uintptr_t Address) const
+{
+    return _Image.IsInSections((const void *)Address, {".data", ".rdata"});
+}
+
+bool IRuntime::ScanSignatures(SigScanner &Scanner, bool IsCritical)
+{
+    for (const auto &[Name, Pattern, IsCriticalPattern] : Signatures::All) {
+        if (IsCriticalPattern != IsCritical) {
+            continue;
+        }
+
+        if (!Scanner.Add(Pattern)) {
+            LOG(Warn, "[IRuntime] Invalid signature. Pattern: \"{}\"", Pattern);
+            return false;
+        }
+    }
+
+    // Telegram is starting up concurrently, leave it some room
+    //
+    uint32_t ThreadCount = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+
+    for (const auto &Region : _CodeRegions) {
+        Scanner.Scan(Region.Begin, Region.Size, ThreadCount);
+    }
+
+    return true;
+}
+
+bool IRuntime::ScanCriticalSignatures()
+{
+    return ScanSignatures(_CriticalScanner, true);
+}
+
+bool IRuntime::ScanDeferredSignatures()
+{
+    return ScanSignatures(_DeferredScanner, false);
+}
+
+const SigScanner::MatchesT &IRuntime::Search(const char *Pattern) const
+{
+    return _CriticalScanner.Contains(Pattern) ? _CriticalScanner.GetMatches(Pattern)
+                                              : _DeferredScanner.GetMatches(Pattern);
+}
+
+SigScanner::MatchesT
+IRuntime::SearchInRange(const char *Pattern, const std::byte *Begin, size_t Size) const
+{
+    SigScanner Scanner;
+    if (!Scanner.Add(Pattern)) {
+        LOG(Warn, "[IRuntime] Invalid signature. Pattern: \"{}\"", Pattern);
+        return {};
+    }
+
+    Scanner.Scan(Begin, Size);
+    return Scanner.GetMatches(Pattern);
+}
+
+// The resolved data is cached across launches, keyed by the Telegram version and a hash of its
+// code. The results are stored as RVAs, each with a snapshot of the bytes it points to, which are
+// verified again on load.
+//
+constexpr auto CacheFileName = "TAR-Cache.json";
+constexpr uint32_t CacheFormat = 1;
+
+std::vector<std::pair<const char *, void **>> IRuntime::GetCachedCodeAddresses(DataT &Data)
+{
+    return {
+        {"Malloc", (void **)&Data.Function.Malloc},
+        {"Free", (void **)&Data.Function.Free},
+        {"EditedIndex", (void **)&Data.Function.EditedIndex},
+        {"SignedIndex", (void **)&Data.Function.SignedIndex},
+        {"ReplyIndex", (void **)&Data.Function.ReplyIndex},
+        {"FnDestroyMessageCaller", (void **)&Data.Address.FnDestroyMessageCaller},
+    };
+}
+
+uint64_t IRuntime::HashCode() const
+{
+    // FNV-1a over a sample of every code page run, hashing all of it would cost as much as the
+    // scan we are trying to skip.
+    //
+    constexpr size_t SampleStride = 0x10000;
+    constexpr size_t SampleSize = 0x100;
+
+    uint64_t Hash = 0xCBF29CE484222325ull;
+    auto Update = [&](const void *Data, size_t Size) {
+        for (size_t i = 0; i < Size; ++i) {
+            Hash = (Hash ^ ((const uint8_t *)Data)[i]) * 0x100000001B3ull;
+        }
+    };
+
+    for (const auto &Region : _CodeRegions) {
+        const uint64_t Rva = Region.Begin - _ModuleBase, Size = Region.Size;
+        Update(&Rva, sizeof(Rva));
+        Update(&Size, sizeof(Size));
+
+        for (size_t Offset = 0; Offset < Region.Size; Offset += SampleStride) {
+            Update(Region.Begin + Offset, std::min(SampleSize, Region.Size - Offset));
+        }
+    }
+
+    return Hash;
+}
+
+const IRuntime::CodeSnapshotT *IRuntime::FindCodeSnapshot(const char *Name) const
+{
+    for (const auto &[SnapshotName, Snapshot] : _CodeSnapshots) {
+        if (std::strcmp(SnapshotName, Name) == 0) {
+            return &Snapshot;
+        }
+    }
+    return nullptr;
+}
+
+void IRuntime::TakeCodeSnapshots()
+{
+    // Called once the critical addresses are resolved and again for the deferred ones, which
+    // nothing patches
+    //
+    for (const auto &[Name, pAddress] : GetCachedCodeAddresses(_Data)) {
+        const auto Address = (const uint8_t *)*pAddress;
+        if (Address == nullptr || FindCodeSnapshot(Name) != nullptr) {
+            continue;
+        }
+
+        CodeSnapshotT Snapshot;
+        std::memcpy(Snapshot.data(), Address, Snapshot.size());
+        _CodeSnapshots.emplace_back(Name, Snapshot);
+    }
+}
+
+bool IRuntime::LoadCache()
+{
+    try {
+        std::ifstream File{CacheFileName};
+        if (!File.good()) {
+            return false;
+        }
+
+        json Root;
+        File >> Root;
+
+        if (Root["format"] != CacheFormat || Root["platform"] != AR_PLATFORM_STR ||
+            Root["file_version"] != _FileVersion || Root["code_hash"] != _CodeHash)
+        {
+            LOG(Info, "[IRuntime] Cache is outdated.");
+            return false;
+        }
+
+        DataT Data = _Data;
+
+        for (const auto &[Name, pAddress] : GetCachedCodeAddresses(Data)) {
+            const auto &Entry = Root["code"][Name];
+            auto Rva = Entry["rva"].get<uint32_t>();
+            auto Snapshot = Entry["bytes"].get<std::vector<uint8_t>>();
+
+            if (Snapshot.size() != CacheSnapshotSize || Rva > _ModuleSize - CacheSnapshotSize ||
+                std::memcmp(_ModuleBase + Rva, Snapshot.data(), CacheSnapshotSize) != 0)
+            {
+                LOG(Warn, "[IRuntime] Cached \"{}\" does not match. RVA: {:#x}", Name, Rva);
+                return false;
+            }
+
+            *pAddress = (void *)(_ModuleBase + Rva);
+        }
+
+        auto CoreAppInstanceRva = Root["lang_instance"]["core_app_rva"].get<uint32_t>();
+        auto pCoreAppInstance = (uintptr_t)(_ModuleBase + CoreAppInstanceRva);
+        if (CoreAppInstanceRva > _ModuleSize - sizeof(uintptr_t) ||
+            !IsInDataSections(pCoreAppInstance))
+        {
+            LOG(Warn, "[IRuntime] Cached CoreAppInstance out of range. RVA: {:#x}",
+                CoreAppInstanceRva);
+            return false;
+        }
+
+        _LangLocator.pCoreAppInstance = pCoreAppInstance;
+        _LangLocator.Offset = Root["lang_instance"]["offset"].get<uint32_t>();
+        Data.Index.ToHistoryMessage = Root["index"].get<uint32_t>();
+
+        _Data = Data;
+        return true;
+    }
+    catch (json::exception &Exception) {
+        LOG(Warn, "[IRuntime] Caught a json exception while loading cache. What: {}",
+            Exception.what());
+        return false;
+    }
+}
+
+void IRuntime::SaveCache()
+{
+    try {
+        json Root;
+        Root["format"] = CacheFormat;
+        Root["platform"] = AR_PLATFORM_STR;
+        Root["file_version"] = _FileVersion;
+        Root["code_hash"] = _CodeHash;
+
+        for (const auto &[Name, pAddress] : GetCachedCodeAddresses(_Data)) {
+            auto pSnapshot = FindCodeSnapshot(Name);
+            if (pSnapshot == nullptr) {
+                LOG(Warn, "[IRuntime] No snapshot of \"{}\", cache not saved.", Name);
+                return;
+            }
+
+            auto &Entry = Root["code"][Name];
+            Entry["rva"] = (uint32_t)((const std::byte *)*pAddress - _ModuleBase);
+            Entry["bytes"] = std::vector<uint8_t>(pSnapshot->begin(), pSnapshot->end());
+        }
+
+        Root["lang_instance"]["core_app_rva"] =
+            (uint32_t)((const std::byte *)_LangLocator.pCoreAppInstance - _ModuleBase);
+        Root["lang_instance"]["offset"] = _LangLocator.Offset;
+        Root["index"] = _Data.Index.ToHistoryMessage;
+
+        std::ofstream File{CacheFileName};
+        File << Root;
+    }
+    catch (const std::exception &Exception) {
+        LOG(Warn, "[IRuntime] Save cache exception: {}", Exception.what());
+    }
 }
 
 // Some of the following instructions are taken from version 1.8.8
@@ -199,14 +605,13 @@ bool IRuntime::InitDynamicData_MallocFree()
     */
     // clang-format on
 
-    auto vMallocResult =
-        _MainModule.search("41 84 C0 75 F9 2B CA 53 56 8D 59 01 53 E8"_sig).matches();
+    auto vMallocResult = Search(Signatures::Malloc);
     if (vMallocResult.size() != 1) {
         LOG(Warn, "[IRuntime] Search malloc failed.");
         return false;
     }
 
-    auto vFreeResult = _MainModule.search("56 E8 ?? ?? ?? ?? 59 5E 5B EB"_sig).matches();
+    auto vFreeResult = Search(Signatures::Free);
     if (vFreeResult.size() != 1) {
         LOG(Warn, "[IRuntime] Search free failed.");
         return false;
@@ -261,16 +666,13 @@ bool IRuntime::InitDynamicData_MallocFree()
     */
     // clang-format on
 
-    auto vMallocResult =
-        _MainModule.search("48 FF C7 80 3C 38 00 75 F7 48 8D 4F 01 E8"_sig).matches();
+    auto vMallocResult = Search(Signatures::Malloc);
     if (vMallocResult.size() != 1) {
         LOG(Warn, "[IRuntime] Search malloc failed.");
         return false;
     }
 
-    auto vFreeResult = _ThisProcess.in_range({vMallocResult.at(0), 0x50})
-                           .search("48 8B CB E8 ?? ?? ?? ?? EB"_sig)
-                           .matches();
+    auto vFreeResult = SearchInRange(Signatures::Free, vMallocResult.at(0), 0x50);
     if (vFreeResult.size() != 1) {
         LOG(Warn, "[IRuntime] Search free failed.");
         return false;
@@ -347,8 +749,7 @@ bool IRuntime::InitDynamicData_DestroyMessage()
 
     // ver < 1.9.15
     if (_FileVersion < 1009015) {
-        auto vResult =
-            _MainModule.search("8B 71 ?? 89 08 85 C9 0F 84 ?? ?? ?? ?? ?? ?? ?? E8"_sig).matches();
+        auto vResult = Search(Signatures::DestroyMessage);
         if (vResult.size() != 1) {
             LOG(Warn, "[IRuntime] Search DestroyMessage failed.");
             return false;
@@ -358,9 +759,7 @@ bool IRuntime::InitDynamicData_DestroyMessage()
     }
     // ver >= 1.9.15
     else if (_FileVersion >= 1009015) {
-        auto vResult =
-            _MainModule.search("51 8B C4 89 08 8B CE E8 ?? ?? ?? ?? 80 BE ?? ?? ?? ?? 00"_sig)
-                .matches();
+        auto vResult = Search(Signatures::DestroyMessageNew);
         if (vResult.size() != 1) {
             LOG(Warn, "[IRuntime] Search new DestroyMessage failed.");
             return false;
@@ -437,11 +836,7 @@ bool IRuntime::InitDynamicData_DestroyMessage()
     */
     // clang-format on
 
-    auto vResult =
-        _MainModule
-            .search(
-                "48 8B 5A 18 48 85 DB 0F 84 ?? ?? ?? ?? 48 8B CB E8 ?? ?? ?? ?? 80 BB ?? ?? ?? ?? 00"_sig)
-            .matches();
+    auto vResult = Search(Signatures::DestroyMessage);
     if (vResult.size() != 1) {
         LOG(Warn, "[IRuntime] Search DestroyMessage failed.");
         return false;
@@ -507,7 +902,7 @@ bool IRuntime::InitDynamicData_EditedIndex()
         */
         // clang-format on
 
-        auto vResult = _MainModule.search("E8 ?? ?? ?? ?? 83 7C 87 ?? ?? 73 ?? E8"_sig).matches();
+        auto vResult = Search(Signatures::EditedIndex);
         if (vResult.size() != 1) {
             LOG(Warn, "[IRuntime] Search EditedIndex failed.");
             return false;
@@ -614,7 +1009,7 @@ bool IRuntime::InitDynamicData_EditedIndex()
         */
         // clang-format on
 
-        auto vResult = _MainModule.search("83 7B 04 FF 74 ?? 8B 47 08 8B 30 E8"_sig).matches();
+        auto vResult = Search(Signatures::EditedIndexNew);
         if (vResult.size() != 1) {
             LOG(Warn, "[IRuntime] Search EditedIndex failed.");
             return false;
@@ -670,7 +1065,7 @@ bool IRuntime::InitDynamicData_EditedIndex()
         */
         // clang-format on
 
-        auto vResult = _MainModule.search("48 83 7C CF 10 08 73 ?? E8"_sig).matches();
+        auto vResult = Search(Signatures::EditedIndex);
         if (vResult.size() != 1) {
             LOG(Warn, "[IRuntime] Search EditedIndex failed.");
             return false;
@@ -759,8 +1154,7 @@ bool IRuntime::InitDynamicData_EditedIndex()
         */
         // clang-format on
 
-        auto vResult =
-            _MainModule.search("83 7A 04 FF 74 ?? 48 8B 41 08 48 8B 18 E8"_sig).matches();
+        auto vResult = Search(Signatures::EditedIndexNew);
         if (vResult.size() != 1) {
             LOG(Warn, "[IRuntime] Search EditedIndex failed. (new)");
             return false;
@@ -846,7 +1240,7 @@ bool IRuntime::InitDynamicData_SignedIndex()
         */
         // clang-format on
 
-        auto vResult = _MainModule.search("E8 ?? ?? ?? ?? 8B 44 87 08 83 CF FF"_sig).matches();
+        auto vResult = Search(Signatures::SignedIndex);
         if (vResult.size() != 1) {
             LOG(Warn, "[IRuntime] Search SignedIndex failed.");
             return false;
@@ -894,7 +1288,7 @@ bool IRuntime::InitDynamicData_SignedIndex()
         */
         // clang-format on
 
-        auto vResult = _MainModule.search("85 F6 75 ?? E8 ?? ?? ?? ?? 33 D2"_sig).matches();
+        auto vResult = Search(Signatures::SignedIndexNew);
         if (vResult.size() != 1) {
             LOG(Warn, "[IRuntime] Search SignedIndex failed. (new)");
             return false;
@@ -961,11 +1355,7 @@ bool IRuntime::InitDynamicData_SignedIndex()
     */
     // clang-format on
 
-    auto vResult =
-        _MainModule
-            .search(
-                "E8 ?? ?? ?? ?? 4C 63 C0 4A 63 44 C3 10 83 F8 08 72 ?? 48 8B D8 48 03 5F 08 EB"_sig)
-            .matches();
+    auto vResult = Search(Signatures::SignedIndex);
     if (vResult.size() != 1) {
         LOG(Warn, "[IRuntime] Search SignedIndex failed.");
         return false;
@@ -1028,7 +1418,7 @@ bool IRuntime::InitDynamicData_ReplyIndex()
     */
     // clang-format on
 
-    auto vResult = _MainModule.search("E8 ?? ?? ?? ?? E8 ?? ?? ?? ?? 8B 46 08 8B 38"_sig).matches();
+    auto vResult = Search(Signatures::ReplyIndex);
     if (vResult.size() != 1) {
         LOG(Warn, "[IRuntime] Search ReplyIndex failed.");
         return false;
@@ -1065,8 +1455,7 @@ bool IRuntime::InitDynamicData_ReplyIndex()
     */
     // clang-format on
 
-    auto vResult =
-        _MainModule.search("E8 ?? ?? ?? ?? 48 63 D0 48 63 44 D3 10 83 F8 08 72 6B"_sig).matches();
+    auto vResult = Search(Signatures::ReplyIndex);
     if (vResult.size() != 1) {
         LOG(Warn, "[IRuntime] Search ReplyIndex failed.");
         return false;
@@ -1085,8 +1474,6 @@ bool IRuntime::InitDynamicData_ReplyIndex()
 
 bool IRuntime::InitDynamicData_LangInstance()
 {
-    using namespace std::chrono_literals;
-
 #if defined PLATFORM_X86
 
     // clang-format off
@@ -1128,9 +1515,7 @@ bool IRuntime::InitDynamicData_LangInstance()
 
     // ver < 2.1.14
     if (_FileVersion < 2001014) {
-        vResult =
-            _MainModule.search("8B 0D ?? ?? ?? ?? 03 C6 0F B7 C0 85 C9 0F 84 ?? ?? ?? ?? 8B 49"_sig)
-                .matches();
+        vResult = Search(Signatures::LangInstance);
         if (vResult.empty()) {
             LOG(Warn, "[IRuntime] Search LangInstance failed. (old)");
             return false;
@@ -1149,9 +1534,7 @@ bool IRuntime::InitDynamicData_LangInstance()
     }
     // ver >= 2.1.14
     else if (_FileVersion >= 2001014) {
-        vResult =
-            _MainModule.search("8B 0D ?? ?? ?? ?? 03 C6 0F B7 C0 85 C9 0F 84 ?? ?? ?? ?? 8B"_sig)
-                .matches();
+        vResult = Search(Signatures::LangInstanceNew);
         if (vResult.empty()) {
             LOG(Warn, "[IRuntime] Search LangInstance failed. (new)");
             return false;
@@ -1206,24 +1589,40 @@ bool IRuntime::InitDynamicData_LangInstance()
     */
     // clang-format on
 
-    auto vResult =
-        _MainModule.search("48 8B 05 ?? ?? ?? ?? 48 8B D9 48 85 C0 0F 84 ?? ?? ?? ?? 48 8B 80"_sig)
-            .matches();
+    auto vResult = Search(Signatures::LangInstance);
     if (vResult.size() != 1) {
         LOG(Warn, "[IRuntime] Search LangInstance failed. (new x64)");
         return false;
     }
 
-    auto pCoreAppInstance = vResult.at(0) + 7 + *(int32_t *)(vResult.at(0) + 3);
+    auto pCoreAppInstance = (uintptr_t)(vResult.at(0) + 7 + *(int32_t *)(vResult.at(0) + 3));
     uint32_t LangInsOffset = *(uint32_t *)(vResult.at(0) + 22);
 
 #else
     #error "Unimplemented."
 #endif
 
+    // The operand is a global variable, anything outside the data sections is a false match
+    //
+    if (!IsInDataSections(pCoreAppInstance)) {
+        LOG(Warn, "[IRuntime] Searched CoreAppInstance is not in a data section. Address: {:#x}",
+            pCoreAppInstance);
+        return false;
+    }
+
+    _LangLocator.pCoreAppInstance = pCoreAppInstance;
+    _LangLocator.Offset = LangInsOffset;
+
+    return true;
+}
+
+bool IRuntime::ResolveLangInstance()
+{
+    using namespace std::chrono_literals;
+
     uintptr_t CoreAppInstance = 0;
     for (size_t i = 0; i < 20; ++i) {
-        CoreAppInstance = *(uintptr_t *)pCoreAppInstance;
+        CoreAppInstance = *(uintptr_t *)_LangLocator.pCoreAppInstance;
         if (CoreAppInstance != 0) {
             break;
         }
@@ -1235,7 +1634,8 @@ bool IRuntime::InitDynamicData_LangInstance()
         return false;
     }
 
-    _Data.Address.pLangInstance = *(LanguageInstance **)(CoreAppInstance + LangInsOffset);
+    _Data.Address.pLangInstance =
+        *(LanguageInstance **)(CoreAppInstance + _LangLocator.Offset);
 
     if (_Data.Address.pLangInstance == nullptr) {
         LOG(Warn, "[IRuntime] Searched pLangInstance is null.");
@@ -1266,9 +1666,7 @@ bool IRuntime::InitDynamicData_IsMessage()
         */
         // clang-format on
 
-        auto vResult =
-            _MainModule.search("8B 49 ?? 85 C9 0F 84 ?? ?? ?? ?? 8B 01 FF 90 ?? ?? ?? ?? 85 C0"_sig)
-                .matches();
+        auto vResult = Search(Signatures::ToHistoryMessageIndex);
         if (vResult.empty()) {
             LOG(Warn, "[IRuntime] Search toHistoryMessage index falied.");
             return false;
@@ -1307,8 +1705,7 @@ bool IRuntime::InitDynamicData_IsMessage()
         */
         // clang-format on
 
-        auto vResult =
-            _MainModule.search("88 4D EF 8B 4D E4 8B 01 8B 40 ?? FF D0 84 C0"_sig).matches();
+        auto vResult = Search(Signatures::IsServiceIndex);
         if (vResult.size() != 1) {
             LOG(Warn, "[IRuntime] Search isService index falied.");
             return false;
@@ -1354,7 +1751,7 @@ bool IRuntime::InitDynamicData_IsMessage()
     */
     // clang-format on
 
-    auto vResult = _MainModule.search("FF 90 ?? ?? ?? ?? C6 43 01 01"_sig).matches();
+    auto vResult = Search(Signatures::ToHistoryMessageIndex);
     if (vResult.size() != 1) {
         LOG(Warn, "[IRuntime] Search toHistoryMessage index falied.");
         return false;
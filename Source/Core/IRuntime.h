@@ -1,43 +1,37 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <vector>
+#include <utility>
+#include <chrono>
+#include <future>
 #include <Windows.h>
 #include <Psapi.h>
 
-#include <sigmatch/sigmatch.hpp>
-
 #include "Telegram.h"
-
-using namespace sigmatch_literals;
+#include "SigScanner.h"
+#include "PeImage.h"
+#include "Layouts.h"
+#include "ResolvedLayout.h"
+#include "Utils.h"
 
 using FnMallocT = void *(__cdecl *)(unsigned int size);
 using FnFreeT = void(__cdecl *)(void *block);
 using FnIndexT = int(__cdecl *)();
 
-class IRuntime
+class IRuntime : NonCopyable
 {
 public:
     struct DataT
     {
-        struct
-        {
-            uint32_t TimeText;
-            uint32_t TimeWidth;
-            uint32_t MainView;
-            // uint32_t Media;
-            uint32_t SignedTimeText;
-            // uint32_t HistoryPeer;
-            uint32_t MaxReplyWidth;
-        } Offset;
+        Layouts::OffsetT Offset; // See `InitFixedData()`
 
-        struct
-        {
-            union {
-                uint32_t ToHistoryMessage;
-                uint32_t IsService;
-            };
-        } Index; // Virtual call index
+        decltype(ResolvedLayoutT::Index) Index; // Virtual call index
+
+        // Returned by the `Function.*Index` functions, resolved once at runtime
+        //
+        decltype(ResolvedLayoutT::ComponentIndex) ComponentIndex;
 
         struct
         {
@@ -55,29 +49,132 @@ public:
         } Address;
     };
 
+    struct LangLocatorT
+    {
+        uintptr_t pCoreAppInstance = 0; // Address of the `Core::Application` instance pointer
+        uint32_t Offset = 0;            // Offset of `Lang::Instance` in `Core::Application`
+    };
+
+    struct TimingT
+    {
+        const char *Name;
+        std::chrono::steady_clock::duration Elapsed;
+    };
+
     static IRuntime &GetInstance();
 
-    const auto &GetData()
+    const auto &GetData() const
     {
         return _Data;
     }
 
+    // Returns nullptr until `WaitDeferredData()` succeeds.
+    //
+    const ResolvedLayoutT *GetLayout() const
+    {
+        return ResolvedLayout::Get();
+    }
+
     auto GetFileVersion() const
     {
         return _FileVersion;
     }
 
+    auto GetModuleBase() const
+    {
+        return _ModuleBase;
+    }
+
+    const auto &GetLangLocator() const
+    {
+        return _LangLocator;
+    }
+
+    // Time spent in each step of the last `ResolveDynamicData()` call.
+    //
+    const auto &GetTimings() const
+    {
+        return _Timings;
+    }
+
     bool Initialize();
 
+    // Initializes with an image that is not necessarily the main module, e.g. one mapped from a
+    // file by the offline resolver. The image must be laid out as the loader would, relocated.
+    //
+    bool Initialize(const std::byte *ModuleBase, size_t ModuleSize, uint32_t FileVersion);
+
+    // Looks up the field offsets for the Telegram version, see `Layouts.h`.
+    //
     bool InitFixedData();
+
+    // Resolves the data the hooks need (`Function.Malloc`, `Function.Free` and
+    // `Address.FnDestroyMessageCaller`), and starts resolving the rest in the background.
+    //
     bool InitDynamicData();
 
+    // Wait for the data resolved in the background. The results are cached, later calls return
+    // immediately.
+    //
+    // `WaitDeferredData()` guards `Index`, `ComponentIndex` and the component index functions,
+    // `WaitLangInstance()` guards `Address.pLangInstance`.
+    //
+    bool WaitDeferredData() const;
+    bool WaitLangInstance() const;
+
+    // Runs the signature scan and all `InitDynamicData_*` resolvers synchronously, bypassing the
+    // cache. Only the locator of `pLangInstance` is resolved, since the instance exists at runtime
+    // only.
+    //
+    bool ResolveDynamicData();
+
 private:
-    sigmatch::this_process_target _ThisProcess;
-    sigmatch::search_context _MainModule;
+    struct RegionT
+    {
+        const std::byte *Begin;
+        size_t Size;
+    };
+
+    const std::byte *_ModuleBase = nullptr;
+    size_t _ModuleSize = 0;
+    PeImage _Image;
+    std::vector<RegionT> _CodeRegions;
+    SigScanner _CriticalScanner, _DeferredScanner;
     uint32_t _FileVersion = 0;
 
     DataT _Data;
+    LangLocatorT _LangLocator;
+    std::vector<TimingT> _Timings;
+    std::shared_future<bool> _DeferredData, _LangInstance;
+    ResolvedLayoutT _Layout = {};
+
+    // Taken before the hooks patch the code, see `TakeCodeSnapshots()`
+    //
+    static constexpr size_t CacheSnapshotSize = 16;
+    using CodeSnapshotT = std::array<uint8_t, CacheSnapshotSize>;
+    uint64_t _CodeHash = 0;
+    std::vector<std::pair<const char *, CodeSnapshotT>> _CodeSnapshots;
+
+    static std::vector<std::pair<const char *, void **>> GetCachedCodeAddresses(DataT &Data);
+    uint64_t HashCode() const;
+    const CodeSnapshotT *FindCodeSnapshot(const char *Name) const;
+    void TakeCodeSnapshots();
+    bool LoadCache();
+    void SaveCache();
+
+    bool IsInDataSections(uintptr_t Address) const;
+    bool ResolveCriticalData();
+    bool ResolveDeferredData();
+    bool ResolveComponentIndices();
+    void PublishLayout();
+    bool RunStep(const char *Name, bool (IRuntime::*Step)());
+
+    bool ScanSignatures(SigScanner &Scanner, bool IsCritical);
+    bool ScanCriticalSignatures();
+    bool ScanDeferredSignatures();
+    const SigScanner::MatchesT &Search(const char *Pattern) const;
+    SigScanner::MatchesT
+    SearchInRange(const char *Pattern, const std::byte *Begin, size_t Size) const;
 
     bool InitDynamicData_MallocFree();
     bool InitDynamicData_DestroyMessage();
@@ -86,4 +183,5 @@ private:
     bool InitDynamicData_ReplyIndex();
     bool InitDynamicData_LangInstance();
     bool InitDynamicData_IsMessage();
+    bool ResolveLangInstance();
 };
@@ -1,5 +1,6 @@
 #include "IUpdater.h"
 
+#include <thread>
 #include <fstream>
 #include <Windows.h>
 #include <wininet.h>
@@ -18,6 +19,12 @@ IUpdater &IUpdater::GetInstance()
     return i;
 }
 
+void IUpdater::SetServers(Internet::ServerT Bridge, Internet::ServerT Direct)
+{
+    _Bridge = std::move(Bridge);
+    _Direct = std::move(Direct);
+}
+
 bool IUpdater::CheckUpdate()
 {
     // Get releases data
@@ -57,6 +64,26 @@ bool IUpdater::CheckUpdate()
     return true;
 }
 
+void IUpdater::CheckUpdateAsync(std::function<void(bool)> Callback)
+{
+    std::thread{[this, Callback = std::move(Callback)]() {
+        bool Result = false;
+
+        // Nothing else would catch it on this thread
+        //
+        try {
+            Result = CheckUpdate();
+        }
+        catch (const std::exception &Exception) {
+            LOG(Warn, "[Updater] Caught an exception. What: {}", Exception.what());
+        }
+
+        if (Callback) {
+            Callback(Result);
+        }
+    }}.detach();
+}
+
 bool IUpdater::ParseResponse(const std::string &Response)
 {
     try {
@@ -235,7 +262,7 @@ std::optional<std::string> IUpdater::GetDataByBridge()
     std::string Response;
     uint32_t Status;
     bool IsSuccessed = Internet::HttpRequest(
-        Response, Status, "POST", "script.google.com",
+        Response, Status, "POST", _Bridge,
         "/macros/s/AKfycbxfGLfG3nXZOIE-t0zFIMGGylBbvj9dc1aiowtAvyh5YEZ69o0/exec",
         {{"Accept", "application/json"}, {"Content-Type", "application/json"}},
         "{\"forward_request\": \"" AR_LATEST_REQUEST "\"}");
@@ -275,7 +302,7 @@ std::optional<std::string> IUpdater::GetDataDirectly()
     std::string Response;
     uint32_t Status;
     bool IsSuccessed = Internet::HttpRequest(
-        Response, Status, "GET", "api.github.com", AR_LATEST_REQUEST,
+        Response, Status, "GET", _Direct, AR_LATEST_REQUEST,
         {
             {"Accept", "application/vnd.github.v3+json"},
         });
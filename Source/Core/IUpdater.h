@@ -2,15 +2,31 @@
 
 #include <string>
 #include <optional>
+#include <functional>
+
+#include "Utils.h"
 
 class IUpdater
 {
 public:
     static IUpdater &GetInstance();
 
+    // The bridge and GitHub by default. Only to be changed before checking, e.g. by tests pointing
+    // both at a local server.
+    //
+    void SetServers(Internet::ServerT Bridge, Internet::ServerT Direct);
+
     bool CheckUpdate();
 
+    // Runs `CheckUpdate()` on its own thread, the outcome is only logged and the update prompt
+    // pops up from that thread. `Callback`, if any, is then called there with the result.
+    //
+    void CheckUpdateAsync(std::function<void(bool)> Callback = {});
+
 private:
+    Internet::ServerT _Bridge{"script.google.com"};
+    Internet::ServerT _Direct{"api.github.com"};
+
     bool ParseResponse(const std::string &Response);
 
     std::optional<std::string> GetDataByBridge();
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+
+// Field offsets of the Telegram classes the plugin accesses, for each range of Telegram versions.
+//
+// Each entry applies from its `MinVersion` up to the `MinVersion` of the next one, versions below
+// the first entry are not supported. Entries can be added or replaced without a rebuild through
+// the override file, see `IRuntime::InitFixedData()`.
+//
+namespace Layouts {
+
+struct OffsetT
+{
+    // HistoryMessage
+    uint32_t TimeText;
+    uint32_t TimeWidth;
+    uint32_t MainView;
+
+    // HistoryMessageEdited, HistoryMessageSigned, HistoryMessageReply
+    uint32_t EditedTimeText;
+    uint32_t SignedTimeText;
+    uint32_t MaxReplyWidth;
+
+    // HistoryView::Element
+    uint32_t ElementMedia;
+
+    // Lang::Instance
+    uint32_t LangId;
+    uint32_t LangPluralId;
+    uint32_t LangName;
+    uint32_t LangNativeName;
+};
+
+struct EntryT
+{
+    uint32_t MinVersion;
+    OffsetT Offset;
+};
+
+// The names used by the override file.
+//
+inline std::vector<std::pair<const char *, uint32_t *>> GetFields(OffsetT &Offset)
+{
+    return {
+        {"time_text", &Offset.TimeText},
+        {"time_width", &Offset.TimeWidth},
+        {"main_view", &Offset.MainView},
+        {"edited_time_text", &Offset.EditedTimeText},
+        {"signed_time_text", &Offset.SignedTimeText},
+        {"max_reply_width", &Offset.MaxReplyWidth},
+        {"element_media", &Offset.ElementMedia},
+        {"lang_id", &Offset.LangId},
+        {"lang_plural_id", &Offset.LangPluralId},
+        {"lang_name", &Offset.LangName},
+        {"lang_native_name", &Offset.LangNativeName},
+    };
+}
+
+// The tables of both platforms are always defined, so the tests can check them on any machine.
+//
+// clang-format off
+constexpr EntryT EmbeddedX86[] = {
+    // MinVersion, {TimeText, TimeWidth, MainView, EditedTimeText, SignedTimeText, MaxReplyWidth,
+    //              ElementMedia, LangId, LangPluralId, LangName, LangNativeName}
+    {2004000, {0x70, 0x74, 0x5C, 0x10, 0x14, 0x6C, 0x24, 0x04, 0x08, 0x14, 0x18}},
+    {2004001, {0x70, 0x74, 0x5C, 0x10, 0x10, 0x6C, 0x24, 0x04, 0x08, 0x14, 0x18}},
+    {2006000, {0x78, 0x7C, 0x60, 0x10, 0x10, 0x6C, 0x24, 0x04, 0x08, 0x14, 0x18}},
+    {2009000, {0x70, 0x74, 0x5C, 0x10, 0x10, 0x6C, 0x24, 0x04, 0x08, 0x14, 0x18}},
+    {3001007, {0x78, 0x7C, 0x64, 0x10, 0x10, 0x74, 0x24, 0x04, 0x08, 0x14, 0x18}},
+};
+// clang-format on
+
+// clang-format off
+constexpr EntryT EmbeddedX64[] = {
+    // MinVersion, {TimeText, TimeWidth, MainView, EditedTimeText, SignedTimeText, MaxReplyWidth,
+    //              ElementMedia, LangId, LangPluralId, LangName, LangNativeName}
+    {0,       {0xB0, 0xB8, 0x98, 0x18, 0x18, 0xA4, 0x38, 0x08, 0x10, 0x28, 0x30}},
+    {3001008, {0xB0, 0xB8, 0x98, 0x18, 0x18, 0xAC, 0x38, 0x08, 0x10, 0x28, 0x30}},
+};
+// clang-format on
+
+#if defined PLATFORM_X86
+inline constexpr auto &Embedded = EmbeddedX86;
+#elif defined PLATFORM_X64
+inline constexpr auto &Embedded = EmbeddedX64;
+#else
+    #error "Unimplemented."
+#endif
+
+// From this version on, `HistoryItem::toHistoryMessage()` is gone and messages are told apart by
+// `HistoryItem::isService()` instead, see `HistoryMessage::IsMessage()`.
+//
+constexpr uint32_t IsServiceMinVersion = 3002005;
+
+// The entry applying to `Version`, i.e. the last one whose `MinVersion` is not greater. Entries
+// must be sorted by `MinVersion`. Returns nullptr if `Version` is older than all of them.
+//
+inline const EntryT *FindEntry(const EntryT *Begin, const EntryT *End, uint32_t Version)
+{
+    auto Found = std::upper_bound(Begin, End, Version, [](uint32_t Value, const EntryT &Entry) {
+        return Value < Entry.MinVersion;
+    });
+    return Found != Begin ? std::prev(Found) : nullptr;
+}
+
+} // namespace Layouts
@@ -0,0 +1,115 @@
+#include "LogArchive.h"
+
+#include <Windows.h>
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace LogArchive {
+
+using FnRtlGetCompressionWorkSpaceSizeT = LONG(NTAPI *)(USHORT Format, PULONG pBufferWorkSpaceSize,
+                                                       PULONG pFragmentWorkSpaceSize);
+using FnRtlCompressBufferT = LONG(NTAPI *)(USHORT Format, PUCHAR pUncompressed,
+                                          ULONG UncompressedSize, PUCHAR pCompressed,
+                                          ULONG CompressedSize, ULONG ChunkSize,
+                                          PULONG pFinalSize, PVOID pWorkSpace);
+using FnRtlDecompressBufferT = LONG(NTAPI *)(USHORT Format, PUCHAR pUncompressed,
+                                            ULONG UncompressedSize, PUCHAR pCompressed,
+                                            ULONG CompressedSize, PULONG pFinalSize);
+
+constexpr USHORT Format = COMPRESSION_FORMAT_LZNT1 | COMPRESSION_ENGINE_STANDARD;
+constexpr size_t HeaderSize = sizeof(Magic) + sizeof(uint64_t);
+
+template <class FnT>
+static FnT GetNtdllFunction(const char *Name)
+{
+    return (FnT)GetProcAddress(GetModuleHandleA("ntdll.dll"), Name);
+}
+
+bool CompressFile(const std::filesystem::path &Source, const std::filesystem::path &Target)
+{
+    static const auto FnGetWorkSpaceSize =
+        GetNtdllFunction<FnRtlGetCompressionWorkSpaceSizeT>("RtlGetCompressionWorkSpaceSize");
+    static const auto FnCompressBuffer =
+        GetNtdllFunction<FnRtlCompressBufferT>("RtlCompressBuffer");
+
+    if (FnGetWorkSpaceSize == nullptr || FnCompressBuffer == nullptr) {
+        return false;
+    }
+
+    std::ifstream Input{Source, std::ios::binary};
+    if (!Input) {
+        return false;
+    }
+    std::string Data{std::istreambuf_iterator<char>{Input}, {}};
+    if (Data.size() > MAXULONG / 2) {
+        return false;
+    }
+
+    ULONG WorkSpaceSize, FragmentWorkSpaceSize;
+    if (FnGetWorkSpaceSize(Format, &WorkSpaceSize, &FragmentWorkSpaceSize) < 0) {
+        return false;
+    }
+    std::vector<uint8_t> WorkSpace(WorkSpaceSize);
+
+    // Incompressible chunks are stored with a 2-byte header each 4 KB
+    //
+    std::vector<uint8_t> Compressed(HeaderSize + Data.size() + Data.size() / 2048 + 16);
+    ULONG CompressedSize;
+
+    if (FnCompressBuffer(
+            Format, (PUCHAR)Data.data(), (ULONG)Data.size(), Compressed.data() + HeaderSize,
+            (ULONG)(Compressed.size() - HeaderSize), 4096, &CompressedSize,
+            WorkSpace.data()) < 0)
+    {
+        return false;
+    }
+
+    const uint64_t OriginalSize = Data.size();
+    std::memcpy(Compressed.data(), Magic, sizeof(Magic));
+    std::memcpy(Compressed.data() + sizeof(Magic), &OriginalSize, sizeof(OriginalSize));
+
+    std::ofstream Output{Target, std::ios::binary | std::ios::trunc};
+    Output.write((const char *)Compressed.data(), HeaderSize + CompressedSize);
+    return Output.good();
+}
+
+bool IsArchive(std::string_view Data)
+{
+    return Data.size() >= HeaderSize && std::memcmp(Data.data(), Magic, sizeof(Magic)) == 0;
+}
+
+std::optional<std::string> Decompress(std::string_view Data)
+{
+    static const auto FnDecompressBuffer =
+        GetNtdllFunction<FnRtlDecompressBufferT>("RtlDecompressBuffer");
+
+    if (FnDecompressBuffer == nullptr || !IsArchive(Data) || Data.size() - HeaderSize > MAXULONG) {
+        return std::nullopt;
+    }
+
+    uint64_t OriginalSize;
+    std::memcpy(&OriginalSize, Data.data() + sizeof(Magic), sizeof(OriginalSize));
+    if (OriginalSize > MAXULONG) {
+        return std::nullopt;
+    }
+
+    std::string Result(OriginalSize, '\0');
+    ULONG FinalSize;
+
+    if (FnDecompressBuffer(
+            Format, (PUCHAR)Result.data(), (ULONG)Result.size(),
+            (PUCHAR)Data.data() + HeaderSize, (ULONG)(Data.size() - HeaderSize),
+            &FinalSize) < 0 ||
+        FinalSize != OriginalSize)
+    {
+        return std::nullopt;
+    }
+
+    return Result;
+}
+
+} // namespace LogArchive
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <optional>
+#include <string_view>
+#include <filesystem>
+
+// Compressed log segments, see `CCustomFileSink`.
+//
+// An archive starts with `Magic` and the uint64_t size of the original file, followed by the whole
+// file compressed as one LZNT1 buffer by `RtlCompressBuffer()`. LZNT1 is available on every
+// supported Windows version and needs no third-party library.
+//
+namespace LogArchive {
+
+constexpr char Magic[8] = {'T', 'A', 'R', 'L', 'Z', 'N', 'T', '1'};
+constexpr char Extension[] = ".lznt1";
+
+// Writes `Source` compressed into `Target`, replacing it if it exists.
+//
+bool CompressFile(const std::filesystem::path &Source, const std::filesystem::path &Target);
+
+bool IsArchive(std::string_view Data);
+
+// Returns nothing if `Data` is not a valid archive.
+//
+std::optional<std::string> Decompress(std::string_view Data);
+
+} // namespace LogArchive
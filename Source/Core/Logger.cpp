@@ -2,13 +2,29 @@
 
 #include <Windows.h>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <cstring>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <condition_variable>
+
+#include <spdlog/fmt/chrono.h>
 #include <spdlog/sinks/sink.h>
 #include <spdlog/pattern_formatter.h>
+#include <spdlog/details/os.h>
 #include <spdlog/details/log_msg.h>
 #include <spdlog/details/file_helper.h>
 
 #include "Config.h"
 #include "Utils.h"
+#include "LogArchive.h"
+#include "MessageRing.h"
 
 namespace Logger {
 
@@ -56,28 +72,80 @@ namespace Logger {
     std::exit(0);
 }
 
+// Writes `ArLog.txt` from a background thread, so `LOG` only copies the message into a ring on the
+// calling thread. That includes the revoke hook on Telegram's UI thread.
+//
+// With deferred logging, messages below warnings are not even formatted on the calling thread, the
+// writer formats them from their encoded arguments. With `AR_BINARY_LOG`, it writes the records of
+// `BinaryLog.h` into `ArLog.bin` instead of text, and nothing is formatted in the process at all.
+//
+// Errors and criticals end the process, so they drain the ring and are written and flushed on the
+// calling thread. So are the rare messages too long for a slot. When the ring is full, e.g. while
+// the writer is held up by the disk, messages are dropped rather than holding up the caller, and
+// the writer logs how many were lost.
+//
+// The writer also rotates the file once it grows too large or too old, and at startup instead of
+// truncating the log of the previous run. Rotated segments, e.g. `ArLog.20210801-120000-000.txt`,
+// are compressed into `LogArchive` files by yet another thread, and the oldest ones are removed
+// to keep the total size of the logs under `MaxTotalSize`.
+//
 template <class MutexT = std::mutex>
-class CCustomFileSink : public spdlog::sinks::sink, NonCopyable, NonMovable
+class CCustomFileSink : public spdlog::sinks::sink,
+                        public std::enable_shared_from_this<CCustomFileSink<MutexT>>,
+                        NonCopyable,
+                        NonMovable
 {
 public:
-    CCustomFileSink(const spdlog::filename_t &Filename)
-        : _Formatter{spdlog::details::make_unique<spdlog::pattern_formatter>()}
+    CCustomFileSink(const std::filesystem::path &Filename)
+        : _Formatter{spdlog::details::make_unique<spdlog::pattern_formatter>()},
+          _Filename{Filename}
     {
-        _FileHelper.open(Filename, true);
+        std::error_code ErrorCode;
+        if (std::filesystem::file_size(_Filename, ErrorCode) != 0 && !ErrorCode) {
+            RenameToSegment();
+        }
+        Open();
     }
 
     ~CCustomFileSink() override = default;
 
+    // The writer keeps the sink alive until the process exits.
+    //
+    void StartWriter()
+    {
+        std::thread{[Self = this->shared_from_this()]() { Self->RunWriter(); }}.detach();
+        StartArchiver();
+    }
+
     void log(const spdlog::details::log_msg &Message) final
     {
-        std::lock_guard<MutexT> Lock{_Mutex};
-        SinkIt(Message);
+        if (Message.level >= spdlog::level::err ||
+            Message.payload.size() > CMessageRing::PayloadCapacity)
+        {
+            std::lock_guard<MutexT> Lock{_Mutex};
+            DrainRing(true);
+            SinkIt(Message);
+            Flush();
+        }
+        else {
+            Enqueue(Message);
+        }
         PostHandler(Message);
     }
 
+    // See `Details::LogDeferred()`.
+    //
+    void LogDeferred(
+        const spdlog::source_loc &Source, spdlog::level::level_enum Level, const char *Format,
+        const std::byte *Args, size_t Size)
+    {
+        Enqueue(Source, Level, Format, Args, Size);
+    }
+
     void flush() final
     {
         std::lock_guard<MutexT> Lock{_Mutex};
+        DrainRing(true);
         Flush();
     }
 
@@ -94,20 +162,340 @@ public:
     }
 
 protected:
+    // The writer wakes up at least this often, and earlier once a batch of messages is queued
+    //
+    static constexpr auto FlushInterval = std::chrono::milliseconds{200};
+    static constexpr size_t WakeBatch = 64;
+
+    static constexpr size_t MaxFileSize = 8 * 1024 * 1024;
+    static constexpr auto MaxFileAge = std::chrono::hours{24};
+    static constexpr uintmax_t MaxTotalSize = 64 * 1024 * 1024; // Including the current file
+
     std::unique_ptr<spdlog::formatter> _Formatter;
     MutexT _Mutex;
+    std::filesystem::path _Filename;
     spdlog::details::file_helper _FileHelper;
+    bool _IsOpen = false;
+    std::chrono::steady_clock::time_point _OpenedAt;
+    std::mutex _ArchiveMutex;
+    CMessageRing _Ring;
+    std::atomic<uint64_t> _DroppedCount = 0;
+    std::mutex _WakeMutex;
+    std::condition_variable _Wake;
+#if defined AR_BINARY_LOG
+    std::unordered_map<const char *, uint32_t> _StringIds;
+#endif
 
-    void SinkIt(const spdlog::details::log_msg &Message)
+    template <class... ArgsT>
+    void Enqueue(const ArgsT &...Args)
     {
+        const auto Position = _Ring.Push(Args...);
+        if (!Position.has_value()) {
+            _DroppedCount.fetch_add(1, std::memory_order_relaxed);
+            _Wake.notify_one();
+            return;
+        }
+
+        if (Position.value() % WakeBatch == WakeBatch - 1) {
+            _Wake.notify_one();
+        }
+    }
+
+    void RunWriter()
+    {
+        std::unique_lock<std::mutex> WakeLock{_WakeMutex};
+
+        while (true) {
+            _Wake.wait_for(WakeLock, FlushInterval);
+
+            std::lock_guard<MutexT> Lock{_Mutex};
+
+            // Nothing may escape this thread. A failed write is retried on the next wake, and so
+            // is opening the file, e.g. while another process holds it. Messages logged while the
+            // file is closed are dropped.
+            //
+            try {
+                if (DrainRing() != 0) {
+                    Flush();
+                }
+
+                if (_IsOpen && (_FileHelper.size() >= MaxFileSize ||
+                                std::chrono::steady_clock::now() - _OpenedAt >= MaxFileAge))
+                {
+                    _FileHelper.close();
+                    _IsOpen = false;
+                    RenameToSegment();
+                    StartArchiver();
+                }
+
+                if (!_IsOpen) {
+                    Open();
+                }
+            }
+            catch (const std::exception &) {
+            }
+        }
+    }
+
+    // Must be called with `_Mutex` held, or before the sink is shared. Throws `spdlog_ex` if the
+    // file can't be opened.
+    //
+    void Open()
+    {
+        _FileHelper.open(_Filename.string(), true);
+        _IsOpen = true;
+        _OpenedAt = std::chrono::steady_clock::now();
+
+#if defined AR_BINARY_LOG
+        // Each file stands on its own, so the strings are written again
+        //
+        _StringIds.clear();
+
+        spdlog::memory_buf_t Magic;
+        Magic.append(std::begin(BinaryLog::Magic), std::end(BinaryLog::Magic));
+        _FileHelper.write(Magic);
+#endif
+    }
+
+    // The time in the name keeps the segments in order when sorted by name. If the rename fails,
+    // the file is truncated as it was before rotation existed.
+    //
+    void RenameToSegment()
+    {
+        const auto Now = std::chrono::system_clock::now();
+        const auto Milliseconds =
+            std::chrono::duration_cast<std::chrono::milliseconds>(Now.time_since_epoch()) % 1000;
+
+        auto Segment = _Filename;
+        Segment.replace_filename(fmt::format(
+            "{}.{:%Y%m%d-%H%M%S}-{:03}{}", _Filename.stem().string(),
+            fmt::localtime(std::chrono::system_clock::to_time_t(Now)), Milliseconds.count(),
+            _Filename.extension().string()));
+
+        std::error_code ErrorCode;
+        std::filesystem::rename(_Filename, Segment, ErrorCode);
+    }
+
+    // Compressing a segment takes a while, so it's done on its own thread to keep the writer
+    // draining the ring
+    //
+    void StartArchiver()
+    {
+        std::thread{[Self = this->shared_from_this()]() {
+            std::lock_guard<std::mutex> Lock{Self->_ArchiveMutex};
+            try {
+                Self->ArchiveSegments();
+            }
+            catch (const std::exception &) {
+            }
+        }}.detach();
+    }
+
+    // Also picks up segments left uncompressed by a previous run that ended too early. Errors are
+    // ignored, logging them would come back to this sink.
+    //
+    void ArchiveSegments()
+    {
+        auto Directory = _Filename.parent_path();
+        if (Directory.empty()) {
+            Directory = ".";
+        }
+
+        // Segments are named "<stem>.<digits>...". Names are compared in their native encoding,
+        // converting any other file name could throw.
+        //
+        auto Prefix = _Filename.stem().native();
+        Prefix.push_back('.');
+        std::vector<std::filesystem::path> Segments;
+        std::error_code ErrorCode;
+
+        std::filesystem::directory_iterator Iterator{Directory, ErrorCode}, End;
+        for (; !ErrorCode && Iterator != End; Iterator.increment(ErrorCode)) {
+            const auto Name = Iterator->path().filename().native();
+            std::error_code EntryErrorCode;
+
+            if (Iterator->is_regular_file(EntryErrorCode) && Name.size() > Prefix.size() &&
+                Name.compare(0, Prefix.size(), Prefix) == 0 && Name[Prefix.size()] >= '0' &&
+                Name[Prefix.size()] <= '9')
+            {
+                Segments.emplace_back(Iterator->path());
+            }
+        }
+
+        for (auto &Segment : Segments) {
+            if (Segment.extension() == LogArchive::Extension) {
+                continue;
+            }
+
+            auto Archive = Segment;
+            Archive += LogArchive::Extension;
+            if (LogArchive::CompressFile(Segment, Archive)) {
+                std::filesystem::remove(Segment, ErrorCode);
+                Segment = std::move(Archive);
+            }
+        }
+
+        // Remove the oldest segments first, with some room left for the current file. A segment
+        // may have been listed with its archive from an interrupted run.
+        //
+        std::sort(Segments.begin(), Segments.end());
+        Segments.erase(std::unique(Segments.begin(), Segments.end()), Segments.end());
+
+        uintmax_t TotalSize = MaxFileSize;
+        for (auto Iterator = Segments.rbegin(); Iterator != Segments.rend(); ++Iterator) {
+            const auto Size = std::filesystem::file_size(*Iterator, ErrorCode);
+            TotalSize += ErrorCode ? 0 : Size;
+            if (TotalSize > MaxTotalSize) {
+                std::filesystem::remove(*Iterator, ErrorCode);
+            }
+        }
+    }
+
+    // Must be called with `_Mutex` held, which makes the caller the single consumer
+    //
+    size_t DrainRing(bool IsComplete = false)
+    {
+        size_t Count = _Ring.Drain(
+            [this](const spdlog::details::log_msg &Message, const char *Format) {
+                SinkIt(Message, Format);
+            },
+            IsComplete);
+
+        // Reported once per drain, after the messages that made it
+        //
+        if (const auto DroppedCount = _DroppedCount.exchange(0, std::memory_order_relaxed);
+            DroppedCount != 0)
+        {
+            const auto Payload = fmt::format(
+                "{} log messages were dropped, the writer fell behind.", DroppedCount);
+            SinkIt(spdlog::details::log_msg{
+                spdlog::source_loc{__FILE__, __LINE__, __FUNCTION__}, BinaryLog::LoggerName,
+                spdlog::level::warn, Payload});
+            ++Count;
+        }
+
+        return Count;
+    }
+
+    // `Format` is set if the payload holds encoded arguments
+    //
+    void SinkIt(const spdlog::details::log_msg &Message, const char *Format = nullptr)
+    {
+        if (!_IsOpen) {
+            return;
+        }
+
+#if defined AR_BINARY_LOG
+        WriteRecord(Message, Format);
+#else
+        if (Format != nullptr) {
+            auto Payload = FormatDeferred(Message, Format);
+
+            spdlog::details::log_msg Formatted{
+                Message.time, Message.source, Message.logger_name, Message.level, Payload};
+            Formatted.thread_id = Message.thread_id;
+            SinkIt(Formatted);
+            return;
+        }
+
         spdlog::memory_buf_t Formatted;
         _Formatter->format(Message, Formatted);
         _FileHelper.write(Formatted);
+#endif
+    }
+
+    // The caller would have reported a mismatch between the format and the arguments through the
+    // error handler, there is nobody to report it to here
+    //
+    static std::string FormatDeferred(const spdlog::details::log_msg &Message, const char *Format)
+    {
+        try {
+            auto Payload = BinaryLog::FormatArgs(
+                Format, (const std::byte *)Message.payload.data(), Message.payload.size());
+            if (Payload.has_value()) {
+                return std::move(Payload.value());
+            }
+            return fmt::format("Malformed arguments for \"{}\".", Format);
+        }
+        catch (const std::exception &Exception) {
+            return fmt::format("Failed to format \"{}\". {}", Format, Exception.what());
+        }
+    }
+
+#if defined AR_BINARY_LOG
+    void WriteRecord(const spdlog::details::log_msg &Message, const char *Format)
+    {
+        spdlog::memory_buf_t Record;
+
+        // Preformatted messages are recorded as the only argument of "{}"
+        //
+        std::vector<std::byte> Text;
+        std::string_view Args{Message.payload.data(), Message.payload.size()};
+        if (Format == nullptr) {
+            Text.resize(Message.payload.size() + sizeof(BinaryLog::ArgType) + sizeof(uint32_t));
+
+            BinaryLog::ArgWriter Writer{Text.data(), Text.size()};
+            Writer.WriteString(Args);
+            Args = std::string_view{(const char *)Text.data(), Writer.GetSize()};
+            Format = "{}";
+        }
+
+        BinaryLog::MessageHeaderT Header;
+        Header.Type = BinaryLog::RecordType::Message;
+        Header.Level = (uint8_t)Message.level;
+        Header.FormatId = GetStringId(Format, Record);
+        Header.FileId = GetStringId(Message.source.filename, Record);
+        Header.FunctionId = GetStringId(Message.source.funcname, Record);
+        Header.Line = (uint32_t)Message.source.line;
+        Header.ThreadId = (uint32_t)Message.thread_id;
+        Header.Time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          Message.time.time_since_epoch())
+                          .count();
+        Header.ArgsSize = (uint32_t)Args.size();
+
+        Append(Record, &Header, sizeof(Header));
+        Append(Record, Args.data(), Args.size());
+        _FileHelper.write(Record);
+    }
+
+    // Strings are identified by their address, they are all literals. A new one is appended to
+    // `Record` before the message using it.
+    //
+    uint32_t GetStringId(const char *String, spdlog::memory_buf_t &Record)
+    {
+        if (String == nullptr) {
+            String = "";
+        }
+
+        auto Iterator = _StringIds.find(String);
+        if (Iterator != _StringIds.end()) {
+            return Iterator->second;
+        }
+
+        const auto Id = (uint32_t)_StringIds.size();
+        _StringIds.emplace(String, Id);
+
+        BinaryLog::StringHeaderT Header;
+        Header.Type = BinaryLog::RecordType::String;
+        Header.Id = Id;
+        Header.Size = (uint32_t)std::strlen(String);
+
+        Append(Record, &Header, sizeof(Header));
+        Append(Record, String, Header.Size);
+        return Id;
+    }
+
+    static void Append(spdlog::memory_buf_t &Record, const void *Data, size_t Size)
+    {
+        Record.append((const char *)Data, (const char *)Data + Size);
     }
+#endif
 
     void Flush()
     {
-        _FileHelper.flush();
+        if (_IsOpen) {
+            _FileHelper.flush();
+        }
     }
 
     void SetPattern(const std::string &Pattern)
@@ -122,7 +510,11 @@ protected:
 
     void PostHandler(const spdlog::details::log_msg &Message)
     {
-        std::string Payload{Message.payload.begin(), Message.payload.end()};
+        // Only copy the payload for the levels that need it, the others are on the hot path
+        //
+        auto GetPayload = [&]() {
+            return std::string{Message.payload.begin(), Message.payload.end()};
+        };
 
         switch (Message.level) {
 #ifdef _DEBUG
@@ -131,26 +523,50 @@ protected:
                 [](std::string Payload) {
                     MessageBoxA(nullptr, Payload.c_str(), "Anti-Revoke Plugin", MB_ICONWARNING);
                 },
-                Payload}
+                GetPayload()}
                 .detach();
             break;
 #endif
         case spdlog::level::err:
-            DoError(Payload, false);
+            DoError(GetPayload(), false);
             break;
 
         case spdlog::level::critical:
-            DoError(Payload, true);
+            DoError(GetPayload(), true);
             break;
         }
     }
 };
 
+// Set once by `Initialize()`, the writer keeps the sink alive
+//
+static CCustomFileSink<> *pDeferredSink = nullptr;
+
+namespace Details {
+
+void PushDeferred(
+    const spdlog::source_loc &srcloc, spdlog::level::level_enum level, const char *format,
+    const std::byte *args, size_t size)
+{
+    if (pDeferredSink != nullptr) {
+        pDeferredSink->LogDeferred(srcloc, level, format, args, size);
+    }
+}
+
+} // namespace Details
+
 void Initialize()
 {
+#if defined AR_BINARY_LOG
+    auto Sink = std::make_shared<CCustomFileSink<>>("ArLog.bin");
+#else
+    auto Sink = std::make_shared<CCustomFileSink<>>("ArLog.txt");
+#endif
+    Sink->StartWriter();
+    pDeferredSink = Sink.get();
+
     auto CustomLogger = std::make_shared<spdlog::logger>(
-        "Main",
-        std::initializer_list<spdlog::sink_ptr>{std::make_shared<CCustomFileSink<>>("ArLog.txt")});
+        BinaryLog::LoggerName, std::initializer_list<spdlog::sink_ptr>{Sink});
 
     spdlog::register_logger(CustomLogger);
     spdlog::set_default_logger(CustomLogger);
@@ -158,7 +574,6 @@ void Initialize()
 #if defined _DEBUG
     spdlog::set_level(spdlog::level::debug);
 #endif
-    spdlog::flush_on(spdlog::level::trace);
 
     spdlog::set_error_handler(
         [](const std::string &Message) { DoError("Spdlog error.\n" + Message, true); });
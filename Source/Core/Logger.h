@@ -1,9 +1,15 @@
 ﻿#pragma once
 
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <optional>
+#include <algorithm>
 
 #include <spdlog/spdlog.h>
 
+#include "BinaryLog.h"
+
 namespace Logger {
 
 namespace Details {
@@ -18,8 +24,125 @@ enum class Level : uint32_t
     Critical,
 };
 
+#if defined AR_DEFERRED_LOG
+constexpr bool IsDeferredLog = true;
+#else
+constexpr bool IsDeferredLog = false;
+#endif
+
+void PushDeferred(
+    const spdlog::source_loc &srcloc, spdlog::level::level_enum level, const char *format,
+    const std::byte *args, size_t size);
+
+// Only encodes the arguments, the message is formatted later on the writer thread or offline.
+// See `BinaryLog.h`.
+//
+template <class... Args>
+inline void LogDeferred(
+    const spdlog::source_loc &srcloc, spdlog::level::level_enum level, const char *format,
+    const Args &...args)
+{
+    std::byte Buffer[BinaryLog::MaxArgsSize];
+    BinaryLog::ArgWriter Writer{Buffer, sizeof(Buffer)};
+
+    if ((Writer.Write(args) && ...)) {
+        PushDeferred(srcloc, level, format, Buffer, Writer.GetSize());
+    }
+    else {
+        spdlog::default_logger_raw()->log(srcloc, level, format, args...);
+    }
+}
+
+// Limits how often a call site logs, so a fault hit by every message costs a line per second
+// instead of flooding the log. Up to `Burst` messages pass at once, then one per `Interval`, and
+// the next one passing reports how many were suppressed.
+//
+// A token bucket kept as the time it is full again, so a single CAS updates it.
+//
+class CRateLimiter
+{
+public:
+    static constexpr auto Interval = std::chrono::seconds{1};
+    static constexpr int64_t Burst = 10;
+
+    // Returns nothing if the message must be suppressed, else the number suppressed before it.
+    //
+    std::optional<uint32_t> Acquire()
+    {
+        constexpr int64_t Step = std::chrono::nanoseconds{Interval}.count();
+
+        const int64_t Now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now().time_since_epoch())
+                                .count();
+
+        int64_t FullAt = _FullAt.load(std::memory_order_relaxed);
+        do {
+            if (FullAt - Step * (Burst - 1) > Now) {
+                _Suppressed.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+        } while (!_FullAt.compare_exchange_weak(
+            FullAt, std::max(FullAt, Now) + Step, std::memory_order_relaxed));
+
+        return _Suppressed.exchange(0, std::memory_order_relaxed);
+    }
+
+    // Lets a message pass without taking a token. Returns the number suppressed before it.
+    //
+    uint32_t Pass()
+    {
+        return _Suppressed.exchange(0, std::memory_order_relaxed);
+    }
+
+    // Whether the message is the same as the last one checked here, see `GetDigest()`.
+    //
+    bool IsRepeat(uint64_t Digest)
+    {
+        return _LastDigest.exchange(Digest, std::memory_order_relaxed) == Digest;
+    }
+
+private:
+    std::atomic<int64_t> _FullAt = 0;
+    std::atomic<uint32_t> _Suppressed = 0;
+    std::atomic<uint64_t> _LastDigest = 0;
+};
+
+// Identifies a message by its format and arguments without formatting it. Arguments too long to
+// encode are identified by the part that fits.
+//
+template <class... Args>
+inline uint64_t GetDigest(const Args &...args)
+{
+    std::byte Buffer[BinaryLog::MaxArgsSize];
+    BinaryLog::ArgWriter Writer{Buffer, sizeof(Buffer)};
+    (void)(Writer.Write(args) && ...);
+
+    // FNV-1a
+    //
+    uint64_t Digest = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < Writer.GetSize(); ++i) {
+        Digest = (Digest ^ (uint8_t)Buffer[i]) * 0x100000001B3ull;
+    }
+    return Digest;
+}
+
 template <Level level, class... Args>
-inline void Log(const spdlog::source_loc &srcloc, Args &&...args)
+inline void Write(
+    const spdlog::source_loc &srcloc, spdlog::level::level_enum spdlogLevel, Args &&...args)
+{
+    // Errors and criticals end the process, and warnings may pop up a message box, so they are
+    // formatted right away
+    //
+    if constexpr (IsDeferredLog && level < Level::Warn) {
+        LogDeferred(srcloc, spdlogLevel, std::forward<Args>(args)...);
+    }
+    else {
+        spdlog::default_logger_raw()->log(srcloc, spdlogLevel, std::forward<Args>(args)...);
+    }
+}
+
+template <Level level, class... Args>
+inline void Log(CRateLimiter &Limiter, const spdlog::source_loc &srcloc, Args &&...args)
 {
     constexpr auto spdlogLevel = []() {
         if constexpr (level == Level::Trace) {
@@ -45,7 +168,36 @@ inline void Log(const spdlog::source_loc &srcloc, Args &&...args)
         }
     }();
 
-    spdlog::default_logger_raw()->log(srcloc, spdlogLevel, std::forward<Args>(args)...);
+    // Errors and criticals end the process, they are never suppressed
+    //
+    if constexpr (level < Level::Error) {
+        if (!spdlog::default_logger_raw()->should_log(spdlogLevel)) {
+            return;
+        }
+
+        // Faults log warnings, with a different address for each message, so every warning
+        // counts against the limit. Below that only exact repeats do, a call site logging the
+        // progress of several steps is no flood.
+        //
+        std::optional<uint32_t> Suppressed;
+        if constexpr (level < Level::Warn) {
+            Suppressed =
+                Limiter.IsRepeat(GetDigest(args...)) ? Limiter.Acquire() : Limiter.Pass();
+        }
+        else {
+            Suppressed = Limiter.Acquire();
+        }
+
+        if (!Suppressed.has_value()) {
+            return;
+        }
+        if (Suppressed.value() != 0) {
+            Write<level>(
+                srcloc, spdlogLevel, "Suppressed {} similar messages.", Suppressed.value());
+        }
+    }
+
+    Write<level>(srcloc, spdlogLevel, std::forward<Args>(args)...);
 }
 
 } // namespace Details
@@ -56,6 +208,12 @@ void Initialize();
 
 } // namespace Logger
 
+// Each expansion has its own rate limiter
+//
 #define LOG(level, ...)                                                                            \
     Logger::Details::Log<Logger::Details::Level::level>(                                           \
+        []() -> Logger::Details::CRateLimiter & {                                                  \
+            static Logger::Details::CRateLimiter i;                                                \
+            return i;                                                                              \
+        }(),                                                                                       \
         spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}, __VA_ARGS__)
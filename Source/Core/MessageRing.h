@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <cstring>
+#include <optional>
+
+#include <spdlog/details/os.h>
+#include <spdlog/details/log_msg.h>
+
+#include "BinaryLog.h"
+#include "NonCopyable.h"
+
+// A bounded lock-free queue of log messages, for any number of producers and a single consumer.
+//
+// Based on Dmitry Vyukov's bounded queue. Each slot carries a sequence number that tells whether
+// it is free for the producer claiming that position, or filled for the consumer. Producers claim
+// positions with a CAS on the head, so they never wait for each other or for the consumer.
+//
+class CMessageRing : NonCopyable, NonMovable
+{
+public:
+    static constexpr size_t Capacity = 1024; // Must be a power of 2
+    static constexpr size_t PayloadCapacity = BinaryLog::MaxArgsSize;
+
+    CMessageRing()
+    {
+        for (size_t i = 0; i < Capacity; ++i) {
+            _Slots[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns the claimed position, or nothing if the ring is full. The payload must fit in
+    // `PayloadCapacity`.
+    //
+    std::optional<size_t> Push(const spdlog::details::log_msg &Message)
+    {
+        // The other fields of `log_msg` point to literals or to the logger, which outlive us
+        //
+        return Emplace([&](SlotT &Slot) {
+            Slot.Time = Message.time;
+            Slot.ThreadId = Message.thread_id;
+            Slot.Source = Message.source;
+            Slot.LoggerName = Message.logger_name;
+            Slot.Level = Message.level;
+            Slot.Format = nullptr;
+            Slot.Size = Message.payload.size();
+            std::memcpy(Slot.Payload, Message.payload.data(), Message.payload.size());
+        });
+    }
+
+    // The same for a message whose arguments are encoded, see `BinaryLog.h`.
+    //
+    std::optional<size_t> Push(
+        const spdlog::source_loc &Source, spdlog::level::level_enum Level, const char *Format,
+        const std::byte *Args, size_t Size)
+    {
+        return Emplace([&](SlotT &Slot) {
+            Slot.Time = spdlog::details::os::now();
+            Slot.ThreadId = spdlog::details::os::thread_id();
+            Slot.Source = Source;
+            Slot.LoggerName = BinaryLog::LoggerName;
+            Slot.Level = Level;
+            Slot.Format = Format;
+            Slot.Size = Size;
+            std::memcpy(Slot.Payload, Args, Size);
+        });
+    }
+
+    // Consumer only. Returns the number of messages passed to `Callback`, with their format if
+    // the payload holds encoded arguments.
+    //
+    // With `IsComplete`, also waits for the messages other threads are still copying in, so
+    // everything pushed before the call is drained.
+    //
+    template <class CallbackT>
+    size_t Drain(CallbackT &&Callback, bool IsComplete = false)
+    {
+        const size_t Head = IsComplete ? _Head.load(std::memory_order_acquire) : 0;
+        size_t Count = 0;
+
+        while (true) {
+            SlotT &Slot = _Slots[_Tail & (Capacity - 1)];
+            if (Slot.Sequence.load(std::memory_order_acquire) != _Tail + 1) {
+                if (_Tail < Head) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                break;
+            }
+
+            spdlog::details::log_msg Message{
+                Slot.Time, Slot.Source, Slot.LoggerName, Slot.Level,
+                spdlog::string_view_t{Slot.Payload, Slot.Size}};
+            Message.thread_id = Slot.ThreadId;
+            Callback(Message, Slot.Format);
+
+            Slot.Sequence.store(_Tail + Capacity, std::memory_order_release);
+            ++_Tail;
+            ++Count;
+        }
+
+        return Count;
+    }
+
+private:
+    struct SlotT
+    {
+        std::atomic<size_t> Sequence;
+        spdlog::log_clock::time_point Time;
+        size_t ThreadId;
+        spdlog::source_loc Source;
+        spdlog::string_view_t LoggerName;
+        spdlog::level::level_enum Level;
+        const char *Format;
+        size_t Size;
+        char Payload[PayloadCapacity];
+    };
+
+    template <class FillT>
+    std::optional<size_t> Emplace(FillT &&Fill)
+    {
+        size_t Position = _Head.load(std::memory_order_relaxed);
+        SlotT *pSlot;
+
+        while (true) {
+            pSlot = &_Slots[Position & (Capacity - 1)];
+            const auto Diff = (intptr_t)pSlot->Sequence.load(std::memory_order_acquire) -
+                              (intptr_t)Position;
+
+            if (Diff == 0) {
+                if (_Head.compare_exchange_weak(
+                        Position, Position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (Diff < 0) {
+                return std::nullopt;
+            }
+            else {
+                Position = _Head.load(std::memory_order_relaxed);
+            }
+        }
+
+        Fill(*pSlot);
+
+        pSlot->Sequence.store(Position + 1, std::memory_order_release);
+        return Position;
+    }
+
+    std::unique_ptr<SlotT[]> _Slots = std::make_unique<SlotT[]>(Capacity);
+    alignas(64) std::atomic<size_t> _Head = 0;
+    alignas(64) size_t _Tail = 0;
+};
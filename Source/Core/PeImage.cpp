@@ -0,0 +1,243 @@
+#include "PeImage.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+template <class T>
+static std::optional<T> ReadAt(const std::byte *Base, size_t Size, size_t Offset)
+{
+    if (Offset > Size || Size - Offset < sizeof(T)) {
+        return std::nullopt;
+    }
+
+    T Value;
+    std::memcpy(&Value, Base + Offset, sizeof(T));
+    return Value;
+}
+
+std::optional<PeImage> PeImage::Parse(const std::byte *Base, size_t Size, Layout ImageLayout)
+{
+    PeImage Result;
+    Result._Base = Base;
+    Result._Size = Size;
+    Result._Layout = ImageLayout;
+
+    // IMAGE_DOS_HEADER
+    //
+    auto DosMagic = ReadAt<uint16_t>(Base, Size, 0);
+    auto NtOffset = ReadAt<uint32_t>(Base, Size, 0x3C);
+    if (DosMagic != 0x5A4D /* MZ */ || !NtOffset.has_value()) {
+        return std::nullopt;
+    }
+
+    // IMAGE_NT_HEADERS
+    //
+    const size_t NtBegin = NtOffset.value();
+    if (ReadAt<uint32_t>(Base, Size, NtBegin) != 0x00004550 /* PE\0\0 */) {
+        return std::nullopt;
+    }
+
+    const size_t FileHeader = NtBegin + 4;
+    auto NumberOfSections = ReadAt<uint16_t>(Base, Size, FileHeader + 2);
+    auto TimeDateStamp = ReadAt<uint32_t>(Base, Size, FileHeader + 4);
+    auto SizeOfOptionalHeader = ReadAt<uint16_t>(Base, Size, FileHeader + 16);
+    if (!NumberOfSections.has_value() || !TimeDateStamp.has_value() ||
+        !SizeOfOptionalHeader.has_value())
+    {
+        return std::nullopt;
+    }
+
+    const size_t OptionalHeader = FileHeader + 20;
+    auto OptionalMagic = ReadAt<uint16_t>(Base, Size, OptionalHeader);
+    size_t DataDirectories;
+    if (OptionalMagic == 0x10B /* PE32 */) {
+        auto ImageBase = ReadAt<uint32_t>(Base, Size, OptionalHeader + 28);
+        if (!ImageBase.has_value()) {
+            return std::nullopt;
+        }
+        Result._Is64Bit = false;
+        Result._ImageBase = ImageBase.value();
+        DataDirectories = OptionalHeader + 92;
+    }
+    else if (OptionalMagic == 0x20B /* PE32+ */) {
+        auto ImageBase = ReadAt<uint64_t>(Base, Size, OptionalHeader + 24);
+        if (!ImageBase.has_value()) {
+            return std::nullopt;
+        }
+        Result._Is64Bit = true;
+        Result._ImageBase = ImageBase.value();
+        DataDirectories = OptionalHeader + 108;
+    }
+    else {
+        return std::nullopt;
+    }
+
+    auto SizeOfImage = ReadAt<uint32_t>(Base, Size, OptionalHeader + 56);
+    auto SizeOfHeaders = ReadAt<uint32_t>(Base, Size, OptionalHeader + 60);
+    auto NumberOfRvaAndSizes = ReadAt<uint32_t>(Base, Size, DataDirectories);
+    if (!SizeOfImage.has_value() || !SizeOfHeaders.has_value() ||
+        !NumberOfRvaAndSizes.has_value())
+    {
+        return std::nullopt;
+    }
+    Result._SizeOfImage = SizeOfImage.value();
+    Result._SizeOfHeaders = SizeOfHeaders.value();
+    Result._TimeDateStamp = TimeDateStamp.value();
+
+    // IMAGE_DATA_DIRECTORY
+    //
+    for (uint32_t i = 0; i < std::min(NumberOfRvaAndSizes.value(), 16u); ++i) {
+        auto Directory = ReadAt<DataDirectoryT>(Base, Size, DataDirectories + 4 + i * 8);
+        if (!Directory.has_value()) {
+            return std::nullopt;
+        }
+        Result._DataDirectories.push_back(Directory.value());
+    }
+
+    // IMAGE_SECTION_HEADER
+    //
+    const size_t SectionTable = OptionalHeader + SizeOfOptionalHeader.value();
+    for (uint16_t i = 0; i < NumberOfSections.value(); ++i) {
+        const size_t Header = SectionTable + i * 40;
+
+        auto RawName = ReadAt<std::array<char, 8>>(Base, Size, Header);
+        auto VirtualSize = ReadAt<uint32_t>(Base, Size, Header + 8);
+        auto VirtualAddress = ReadAt<uint32_t>(Base, Size, Header + 12);
+        auto SizeOfRawData = ReadAt<uint32_t>(Base, Size, Header + 16);
+        auto PointerToRawData = ReadAt<uint32_t>(Base, Size, Header + 20);
+        auto Characteristics = ReadAt<uint32_t>(Base, Size, Header + 36);
+        if (!Characteristics.has_value()) {
+            return std::nullopt;
+        }
+
+        const auto &Name = RawName.value();
+        Result._Sections.push_back(SectionT{
+            std::string{Name.data(), strnlen(Name.data(), Name.size())}, VirtualAddress.value(),
+            VirtualSize.value(), PointerToRawData.value(), SizeOfRawData.value(),
+            Characteristics.value()});
+    }
+
+    return Result;
+}
+
+const PeImage::SectionT *PeImage::FindSection(std::string_view Name) const
+{
+    auto Iterator = std::find_if(_Sections.begin(), _Sections.end(), [&](const SectionT &Section) {
+        return Section.Name == Name;
+    });
+    return Iterator != _Sections.end() ? &*Iterator : nullptr;
+}
+
+const PeImage::SectionT *PeImage::FindSectionByRva(uint32_t Rva) const
+{
+    for (const SectionT &Section : _Sections) {
+        const uint32_t Extent = std::max(Section.VirtualSize, Section.SizeOfRawData);
+        if (Rva >= Section.VirtualAddress && Rva - Section.VirtualAddress < Extent) {
+            return &Section;
+        }
+    }
+    return nullptr;
+}
+
+const std::byte *PeImage::GetSectionBegin(const SectionT &Section) const
+{
+    return _Base +
+           (_Layout == Layout::Mapped ? Section.VirtualAddress : Section.PointerToRawData);
+}
+
+size_t PeImage::GetSectionSize(const SectionT &Section) const
+{
+    const size_t Offset = GetSectionBegin(Section) - _Base;
+    if (Offset >= _Size) {
+        return 0;
+    }
+
+    const size_t Extent = _Layout == Layout::Mapped
+                              ? Section.VirtualSize
+                              : std::min(Section.VirtualSize, Section.SizeOfRawData);
+    return std::min(Extent, _Size - Offset);
+}
+
+const std::byte *PeImage::GetPointer(uint32_t Rva) const
+{
+    if (_Layout == Layout::Mapped) {
+        return Rva < _Size ? _Base + Rva : nullptr;
+    }
+
+    if (Rva < _SizeOfHeaders) {
+        return Rva < _Size ? _Base + Rva : nullptr;
+    }
+
+    const SectionT *Section = FindSectionByRva(Rva);
+    if (Section == nullptr || Rva - Section->VirtualAddress >= GetSectionSize(*Section)) {
+        return nullptr;
+    }
+    return GetSectionBegin(*Section) + (Rva - Section->VirtualAddress);
+}
+
+std::optional<std::vector<uint32_t>> PeImage::GetRelocations() const
+{
+    // IMAGE_BASE_RELOCATION blocks, each followed by 16-bit entries of a 4-bit type and a 12-bit
+    // offset into the page
+    //
+    constexpr uint16_t RelBasedAbsolute = 0, RelBasedHighLow = 3, RelBasedDir64 = 10;
+
+    const DataDirectoryT Directory = GetDataDirectory(DirectoryBaseReloc);
+    const uint16_t PointerType = _Is64Bit ? RelBasedDir64 : RelBasedHighLow;
+
+    std::vector<uint32_t> Result;
+
+    for (uint32_t Offset = 0; Offset + 8 <= Directory.Size;) {
+        const std::byte *Block = GetPointer(Directory.VirtualAddress + Offset);
+        if (Block == nullptr) {
+            return std::nullopt;
+        }
+
+        uint32_t PageRva, BlockSize;
+        std::memcpy(&PageRva, Block, sizeof(PageRva));
+        std::memcpy(&BlockSize, Block + 4, sizeof(BlockSize));
+        if (BlockSize < 8 || BlockSize > Directory.Size - Offset) {
+            return std::nullopt;
+        }
+
+        for (uint32_t i = 8; i + 2 <= BlockSize; i += 2) {
+            const std::byte *pEntry = GetPointer(Directory.VirtualAddress + Offset + i);
+            if (pEntry == nullptr) {
+                return std::nullopt;
+            }
+
+            uint16_t Entry;
+            std::memcpy(&Entry, pEntry, sizeof(Entry));
+
+            const uint16_t Type = Entry >> 12;
+            if (Type == PointerType) {
+                Result.push_back(PageRva + (Entry & 0xFFF));
+            }
+            else if (Type != RelBasedAbsolute) {
+                return std::nullopt;
+            }
+        }
+
+        Offset += BlockSize;
+    }
+
+    return Result;
+}
+
+bool PeImage::IsInSections(
+    const void *Address, std::initializer_list<std::string_view> Names) const
+{
+    for (std::string_view Name : Names) {
+        const SectionT *Section = FindSection(Name);
+        if (Section == nullptr) {
+            continue;
+        }
+
+        auto Begin = GetSectionBegin(*Section);
+        if (Address >= Begin && Address < Begin + GetSectionSize(*Section)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <initializer_list>
+
+// A minimal, platform independent PE header parser.
+//
+// It works on both a module loaded by the system (sections at their RVAs) and a file read from
+// disk (sections at their raw offsets).
+//
+class PeImage
+{
+public:
+    enum class Layout : uint32_t
+    {
+        Mapped,
+        File,
+    };
+
+    struct SectionT
+    {
+        std::string Name;
+        uint32_t VirtualAddress;
+        uint32_t VirtualSize;
+        uint32_t PointerToRawData;
+        uint32_t SizeOfRawData;
+        uint32_t Characteristics;
+    };
+
+    struct DataDirectoryT
+    {
+        uint32_t VirtualAddress;
+        uint32_t Size;
+    };
+
+    static constexpr uint32_t SectionExecute = 0x20000000; // IMAGE_SCN_MEM_EXECUTE
+    static constexpr uint32_t DirectoryBaseReloc = 5;      // IMAGE_DIRECTORY_ENTRY_BASERELOC
+
+    static std::optional<PeImage> Parse(const std::byte *Base, size_t Size, Layout ImageLayout);
+
+    bool Is64Bit() const
+    {
+        return _Is64Bit;
+    }
+
+    uint64_t GetImageBase() const
+    {
+        return _ImageBase;
+    }
+
+    uint32_t GetSizeOfImage() const
+    {
+        return _SizeOfImage;
+    }
+
+    uint32_t GetSizeOfHeaders() const
+    {
+        return _SizeOfHeaders;
+    }
+
+    uint32_t GetTimeDateStamp() const
+    {
+        return _TimeDateStamp;
+    }
+
+    DataDirectoryT GetDataDirectory(uint32_t Index) const
+    {
+        return Index < _DataDirectories.size() ? _DataDirectories[Index] : DataDirectoryT{};
+    }
+
+    const std::vector<SectionT> &GetSections() const
+    {
+        return _Sections;
+    }
+
+    const SectionT *FindSection(std::string_view Name) const;
+    const SectionT *FindSectionByRva(uint32_t Rva) const;
+
+    // The bytes of a section as laid out in the parsed buffer. Only the initialized part is
+    // returned for a file layout.
+    //
+    const std::byte *GetSectionBegin(const SectionT &Section) const;
+    size_t GetSectionSize(const SectionT &Section) const;
+
+    // Translates an RVA to the parsed buffer. Returns nullptr if it is not backed by the buffer.
+    //
+    const std::byte *GetPointer(uint32_t Rva) const;
+
+    // RVAs of all pointer-sized fixups in the base relocation table.
+    //
+    std::optional<std::vector<uint32_t>> GetRelocations() const;
+
+    // Whether `Address` (in the parsed buffer) lies in one of the named sections.
+    //
+    bool IsInSections(const void *Address, std::initializer_list<std::string_view> Names) const;
+
+private:
+    const std::byte *_Base = nullptr;
+    size_t _Size = 0;
+    Layout _Layout = Layout::Mapped;
+    bool _Is64Bit = false;
+    uint64_t _ImageBase = 0;
+    uint32_t _SizeOfImage = 0;
+    uint32_t _SizeOfHeaders = 0;
+    uint32_t _TimeDateStamp = 0;
+    std::vector<DataDirectoryT> _DataDirectories;
+    std::vector<SectionT> _Sections;
+};
@@ -1,21 +1,26 @@
 ﻿#include "QtString.h"
-#include "IRuntime.h"
-#include "IAntiRevoke.h"
+#include "ReadableMemory.h"
+
+#if defined OS_WIN
+    #include "IRuntime.h"
+    #include "IAntiRevoke.h"
+#endif
 
 QtString::QtString() {}
 
-QtString::QtString(const wchar_t *String)
+bool QtString::IsValidTime(ReadableMemory &Memory)
 {
-    MakeString(String);
-}
+    if (d == nullptr || !Memory.IsReadable(d, sizeof(QtArrayData)) ||
+        !Memory.IsReadable((void *)((uintptr_t)d + d->offset), sizeof(QtArrayData) + 12))
+    {
+        return false;
+    }
 
-bool QtString::IsValidTime()
-{
-    // Check valid
-    return d != nullptr && !IsBadReadPtr(d, sizeof(void *)) &&
-           !IsBadReadPtr((void *)((uintptr_t)d + d->offset), sizeof(QtArrayData) + 12) &&
-           GetRefCount() <= 1 &&
-           wcslen(GetText()) <= 8; // Fixed for 12h format. ("12:34 AM" / "12:34 PM")
+    // Static data is never counted. Any other count below 1 is unsharable or not a string at all.
+    //
+    const int32_t RefCount = GetRefCount();
+    return (RefCount == -1 || RefCount >= 1) &&
+           GetView().size() <= 8; // Fixed for 12h format. ("12:34 AM" / "12:34 PM")
 }
 
 wchar_t *QtString::GetText()
@@ -23,14 +28,25 @@ wchar_t *QtString::GetText()
     return (wchar_t *)((uintptr_t)d + d->offset);
 }
 
+std::wstring_view QtString::GetView()
+{
+    return {GetText(), (size_t)d->size};
+}
+
 bool QtString::IsEmpty()
 {
-    return wcscmp(GetText(), L"") == 0;
+    return d->size == 0;
 }
 
-size_t QtString::Find(const std::wstring &String)
+size_t QtString::Find(std::wstring_view String)
 {
-    return std::wstring(GetText()).find(String);
+    return GetView().find(String);
+}
+
+bool QtString::StartsWith(std::wstring_view Prefix, size_t Pos)
+{
+    auto View = GetView();
+    return Pos <= View.size() && View.substr(Pos).starts_with(Prefix);
 }
 
 int32_t QtString::GetRefCount()
@@ -38,6 +54,31 @@ int32_t QtString::GetRefCount()
     return d->ref;
 }
 
+QtArrayData *QtString::GetData()
+{
+    return d;
+}
+
+void QtString::Swap(QtString *Dst)
+{
+    QtArrayData *SaveData = Dst->d;
+
+    Dst->d = d;
+    d = SaveData;
+}
+
+#if defined OS_WIN
+
+QtString::QtString(const wchar_t *String)
+{
+    MakeString(String);
+}
+
+bool QtString::IsValidTime()
+{
+    return IsValidTime(ReadableMemory::GetInstance());
+}
+
 void QtString::MakeString(const wchar_t *String)
 {
     size_t Length = wcslen(String);
@@ -58,22 +99,59 @@ void QtString::MakeString(const wchar_t *String)
     memcpy(GetText(), String, StrBytes);
 }
 
-void QtString::Swap(QtString *Dst)
+void QtString::Replace(const wchar_t *NewContent)
 {
-    QtArrayData *SaveData = Dst->d;
-
-    Dst->d = d;
-    d = SaveData;
+    QtString NewText(NewContent);
+    NewText.Swap(this);
+    NewText.Clear();
 }
 
-void QtString::Replace(const wchar_t *NewContent)
+void QtString::Assign(QtArrayData *Data)
 {
-    QtString NewText(NewContent);
+    QtString NewText;
+    if (AddRef(Data)) {
+        NewText.d = Data;
+    }
+    else {
+        NewText.MakeString((const wchar_t *)((uintptr_t)Data + Data->offset));
+    }
+
     NewText.Swap(this);
     NewText.Clear();
 }
 
 void QtString::Clear()
 {
-    IAntiRevoke::GetInstance().CallFree(d);
+    Release(d);
+    d = nullptr;
+}
+
+bool QtString::AddRef(QtArrayData *Data)
+{
+    // Same as Qt's `RefCount::ref()`, unsharable data (ref 0) must be copied instead
+    //
+    if (Data->ref == 0) {
+        return false;
+    }
+
+    if (Data->ref != -1) {
+        InterlockedIncrement((volatile LONG *)&Data->ref);
+    }
+    return true;
+}
+
+void QtString::Release(QtArrayData *Data)
+{
+    if (Data == nullptr || Data->ref == -1) {
+        return;
+    }
+
+    // Same as Qt's `RefCount::deref()`, unsharable data has a single owner and is freed without
+    // being counted
+    //
+    if (Data->ref == 0 || InterlockedDecrement((volatile LONG *)&Data->ref) == 0) {
+        IAntiRevoke::GetInstance().CallFree(Data);
+    }
 }
+
+#endif
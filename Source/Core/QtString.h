@@ -1,6 +1,11 @@
 ﻿#pragma once
 
 #include <string>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+class ReadableMemory;
 
 /*
     由于直接引用 Qt 静态库，注入会出现找不到 DLL 文件的情况。
@@ -26,16 +31,41 @@ public:
     QtString();
     QtString(const wchar_t *String);
 
+    // Checks the text looks like a time Telegram laid out. It may be static or shared by any
+    // number of strings, e.g. a marked text is shared by all messages marked in the same minute.
+    //
     bool IsValidTime();
+    bool IsValidTime(ReadableMemory &Memory);
+
     wchar_t *GetText();
+
+    // A view of the text bounded by the stored size, valid until the string is modified.
+    //
+    std::wstring_view GetView();
+
     bool IsEmpty();
-    size_t Find(const std::wstring &String);
+    size_t Find(std::wstring_view String);
+    bool StartsWith(std::wstring_view Prefix, size_t Pos = 0);
     int32_t GetRefCount();
+    QtArrayData *GetData();
     void MakeString(const wchar_t *String);
     void Swap(QtString *Dst);
     void Replace(const wchar_t *NewContent);
+
+    // Shares `Data` in place of the current text, which is released. Unsharable data is copied.
+    //
+    void Assign(QtArrayData *Data);
+
+    // Releases the current text, it is freed when no other string shares it.
+    //
     void Clear();
 
+    // Qt's own reference counting, static data (ref -1) is never counted or freed. Unsharable
+    // data (ref 0) can't be referenced, `AddRef()` returns false for it.
+    //
+    static bool AddRef(QtArrayData *Data);
+    static void Release(QtArrayData *Data);
+
 private:
     QtArrayData *d = nullptr;
 };
@@ -0,0 +1,106 @@
+#include "ReadableMemory.h"
+
+#include <algorithm>
+#include <iterator>
+
+#if defined OS_WIN
+    #include <Windows.h>
+#endif
+
+#if defined OS_WIN
+
+static std::optional<ReadableMemory::RegionT> QueryVirtualMemory(uintptr_t Address)
+{
+    MEMORY_BASIC_INFORMATION Info;
+    if (VirtualQuery((const void *)Address, &Info, sizeof(Info)) == 0) {
+        return std::nullopt;
+    }
+
+    constexpr DWORD Readable = PAGE_READONLY | PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READ |
+                               PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+
+    if (Info.State != MEM_COMMIT || (Info.Protect & Readable) == 0 ||
+        (Info.Protect & (PAGE_GUARD | PAGE_NOACCESS)) != 0)
+    {
+        return std::nullopt;
+    }
+
+    const auto Begin = (uintptr_t)Info.BaseAddress;
+    return ReadableMemory::RegionT{Begin, Begin + Info.RegionSize};
+}
+
+ReadableMemory &ReadableMemory::GetInstance()
+{
+    // Heap segments are rarely released while Telegram is running, so a region is trusted for a
+    // few seconds before it is queried again.
+    //
+    static ReadableMemory i{QueryVirtualMemory, std::chrono::seconds{5}};
+    return i;
+}
+
+#endif
+
+ReadableMemory::ReadableMemory(QueryT Query, std::chrono::milliseconds Lifetime)
+    : _Query{std::move(Query)}, _Lifetime{Lifetime}
+{
+}
+
+bool ReadableMemory::IsReadable(const void *Address, size_t Size)
+{
+    const auto Begin = (uintptr_t)Address;
+    const auto End = Begin + std::max<size_t>(Size, 1);
+    if (Begin == 0 || End < Begin) {
+        return false;
+    }
+
+    const auto Now = Clock::now();
+    std::lock_guard<std::mutex> Lock(_Mutex);
+
+    // The range may span several adjacent regions
+    //
+    for (uintptr_t Current = Begin; Current < End;) {
+        auto RegionEnd = FindRegionEnd(Current, Now);
+        if (!RegionEnd.has_value()) {
+            return false;
+        }
+        Current = RegionEnd.value();
+    }
+
+    return true;
+}
+
+std::optional<uintptr_t> ReadableMemory::FindRegionEnd(uintptr_t Address, Clock::time_point Now)
+{
+    // The last region beginning at or before `Address`
+    //
+    auto Iterator = _Regions.upper_bound(Address);
+    if (Iterator != _Regions.begin()) {
+        --Iterator;
+        if (Address < Iterator->second.End) {
+            if (Now - Iterator->second.QueriedAt < _Lifetime) {
+                return Iterator->second.End;
+            }
+            _Regions.erase(Iterator);
+        }
+    }
+
+    // Unreadable addresses are not cached, they are rare and may become readable at any time
+    //
+    auto Region = _Query(Address);
+    if (!Region.has_value()) {
+        return std::nullopt;
+    }
+
+    // Cached regions overlapping the new one are outdated
+    //
+    Iterator = _Regions.lower_bound(Region->Begin);
+    if (Iterator != _Regions.begin() && std::prev(Iterator)->second.End > Region->Begin) {
+        --Iterator;
+    }
+    while (Iterator != _Regions.end() && Iterator->first < Region->End) {
+        Iterator = _Regions.erase(Iterator);
+    }
+
+    _Regions.emplace(Region->Begin, EntryT{Region->End, Now});
+    return Region->End;
+}
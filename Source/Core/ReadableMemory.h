@@ -0,0 +1,59 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <functional>
+
+#include "NonCopyable.h"
+
+// Answers whether a range of memory can be read, from a cache of the readable regions of the
+// process instead of probing pages like `IsBadReadPtr()` does.
+//
+// Regions are looked up with a binary search. An address outside the cached regions, or in a
+// region cached too long ago, is queried again, so the cache follows allocations and frees
+// incrementally. A region freed since it was cached may still be reported readable until it
+// expires, so callers must keep their own exception handling.
+//
+// The query is a parameter, so the cache can be driven by something other than `VirtualQuery()`.
+//
+class ReadableMemory : NonCopyable, NonMovable
+{
+public:
+    struct RegionT
+    {
+        uintptr_t Begin;
+        uintptr_t End;
+    };
+
+    // Returns the readable region containing `Address`, if any.
+    //
+    using QueryT = std::function<std::optional<RegionT>(uintptr_t Address)>;
+
+    // The process-wide instance, backed by `VirtualQuery()`. Only on Windows, elsewhere instances
+    // are constructed with a query of their own.
+    //
+    static ReadableMemory &GetInstance();
+
+    explicit ReadableMemory(QueryT Query, std::chrono::milliseconds Lifetime);
+
+    bool IsReadable(const void *Address, size_t Size);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct EntryT
+    {
+        uintptr_t End;
+        Clock::time_point QueriedAt;
+    };
+
+    QueryT _Query;
+    Clock::duration _Lifetime;
+    std::mutex _Mutex;
+    std::map<uintptr_t, EntryT> _Regions; // Keyed by the beginning of each region
+
+    std::optional<uintptr_t> FindRegionEnd(uintptr_t Address, Clock::time_point Now);
+};
@@ -39,7 +39,10 @@ ULONG WINAPI Initialize(PVOID pParameter)
         return 0;
     }
 
-    IUpdater::GetInstance().CheckUpdate();
+    // The requests time out after 30 seconds each, so waiting for them here could hold back the
+    // hooks for a minute on a slow network, and revoked messages would be lost meanwhile
+    //
+    IUpdater::GetInstance().CheckUpdateAsync();
 
     if (!Runtime.InitFixedData()) {
         LOG(Error,
@@ -52,8 +55,17 @@ ULONG WINAPI Initialize(PVOID pParameter)
         return 0;
     }
 
-    AntiRevoke.InitMarker();
+    // Install the hooks as soon as possible, revoked messages are queued until the rest of the
+    // data is resolved
+    //
     AntiRevoke.SetupHooks();
+
+    if (!Runtime.WaitDeferredData()) {
+        LOG(Critical, "[IRuntime] Resolving deferred data failed.");
+        return 0;
+    }
+
+    AntiRevoke.InitMarker();
     AntiRevoke.ProcessBlockedMessages();
 
     return 0;
@@ -0,0 +1,53 @@
+#include "ResolvedLayout.h"
+
+#include <atomic>
+
+static std::atomic<const ResolvedLayoutT *> pPublishedLayout = nullptr;
+
+// The virtual function at `Index` in the table of `This`
+//
+template <typename FnT>
+static FnT GetVirtual(HistoryMessage *This, uint32_t Index)
+{
+    return (FnT)((*(void ***)This)[Index]);
+}
+
+// ver < 3.2.5
+//
+static bool IsMessageByToHistoryMessage(HistoryMessage *This, uint32_t Index)
+{
+    // HistoryMessage *HistoryItem::toHistoryMessage()
+    //
+    using FnToHistoryMessageT = HistoryMessage *(*)(HistoryMessage * This);
+    return GetVirtual<FnToHistoryMessageT>(This, Index)(This) != nullptr;
+}
+
+// ver >= 3.2.5
+//
+static bool IsMessageByIsService(HistoryMessage *This, uint32_t Index)
+{
+    // bool HistoryItem::isService() const
+    //
+    using FnIsServiceT = bool (*)(HistoryMessage * This);
+    return !GetVirtual<FnIsServiceT>(This, Index)(This);
+}
+
+namespace ResolvedLayout {
+
+HistoryMessage::FnIsMessageT SelectIsMessage(uint32_t FileVersion)
+{
+    return FileVersion < Layouts::IsServiceMinVersion ? &IsMessageByToHistoryMessage
+                                                      : &IsMessageByIsService;
+}
+
+const ResolvedLayoutT *Get()
+{
+    return pPublishedLayout.load(std::memory_order_acquire);
+}
+
+void Publish(const ResolvedLayoutT *pLayout)
+{
+    pPublishedLayout.store(pLayout, std::memory_order_release);
+}
+
+} // namespace ResolvedLayout
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "Layouts.h"
+#include "Telegram.h"
+
+// What the `Telegram.cpp` accessors read on the hook path, copied out of `IRuntime::DataT` once
+// all of it is resolved and never modified afterwards.
+//
+struct ResolvedLayoutT
+{
+    Layouts::OffsetT Offset;
+
+    struct
+    {
+        union {
+            uint32_t ToHistoryMessage;
+            uint32_t IsService;
+        };
+    } Index; // Virtual call index
+
+    struct
+    {
+        uint32_t Edited;
+        uint32_t Signed;
+        uint32_t Reply;
+    } ComponentIndex; // Returned by the component index functions, resolved once at runtime
+
+    // Selected by the version, see `ResolvedLayout::SelectIsMessage()`
+    //
+    HistoryMessage::FnIsMessageT FnIsMessage;
+};
+static_assert(std::is_trivially_copyable_v<ResolvedLayoutT>);
+
+// Kept apart from `IRuntime`, which needs Windows, so the accessors can be tested on any machine.
+//
+namespace ResolvedLayout {
+
+// Selects the `IsMessage()` implementation for a version of Telegram, so it is not checked on
+// every call.
+//
+HistoryMessage::FnIsMessageT SelectIsMessage(uint32_t FileVersion);
+
+// The layout the accessors read, nullptr until one is published.
+//
+const ResolvedLayoutT *Get();
+
+// `Layout` must stay alive and unmodified for as long as it is published.
+//
+void Publish(const ResolvedLayoutT *pLayout);
+
+} // namespace ResolvedLayout
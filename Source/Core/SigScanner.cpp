@@ -0,0 +1,433 @@
+#include "SigScanner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <thread>
+
+#if defined _M_IX86 || defined _M_X64 || defined __i386__ || defined __x86_64__
+    #define SIG_SCANNER_X86_SIMD
+
+    #include <immintrin.h>
+
+    #if defined _MSC_VER
+        #include <intrin.h>
+        #define SIG_SCANNER_TARGET_AVX2
+    #else
+        #include <cpuid.h>
+        #define SIG_SCANNER_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+// Bytes that occur most often in compiled x86/x64 code, most frequent first.
+// Bytes not listed are considered rare.
+//
+constexpr uint8_t FrequentBytes[] = {
+    0x00, 0xFF, 0x8B, 0x48, 0x89, 0xCC, 0x0F, 0x24, 0x44, 0x4C, 0x85, 0xE8, 0x83, 0x01,
+    0x8D, 0xC0, 0x74, 0x75, 0x08, 0x10, 0x04, 0x45, 0xC3, 0x50, 0x40, 0x20, 0x18, 0x8E};
+
+static size_t GetByteFrequencyRank(uint8_t Byte)
+{
+    auto Iterator = std::find(std::begin(FrequentBytes), std::end(FrequentBytes), Byte);
+    return (size_t)(std::end(FrequentBytes) - Iterator);
+}
+
+static std::optional<uint8_t> ParseHexDigit(char Char)
+{
+    if (Char >= '0' && Char <= '9') {
+        return (uint8_t)(Char - '0');
+    }
+    if (Char >= 'A' && Char <= 'F') {
+        return (uint8_t)(Char - 'A' + 10);
+    }
+    if (Char >= 'a' && Char <= 'f') {
+        return (uint8_t)(Char - 'a' + 10);
+    }
+    return std::nullopt;
+}
+
+//////////////////////////////////////////////////
+// Signature
+//
+
+std::optional<Signature> Signature::Parse(std::string_view Pattern)
+{
+    Signature Result;
+
+    size_t Pos = 0;
+    while (Pos < Pattern.size()) {
+        if (Pattern[Pos] == ' ') {
+            ++Pos;
+            continue;
+        }
+
+        size_t End = Pattern.find(' ', Pos);
+        if (End == std::string_view::npos) {
+            End = Pattern.size();
+        }
+
+        std::string_view Token = Pattern.substr(Pos, End - Pos);
+        Pos = End;
+
+        if (Token == "??" || Token == "?") {
+            Result._Bytes.push_back(0);
+            Result._Mask.push_back(0x00);
+            continue;
+        }
+
+        if (Token.size() != 2) {
+            return std::nullopt;
+        }
+
+        auto High = ParseHexDigit(Token[0]), Low = ParseHexDigit(Token[1]);
+        if (!High.has_value() || !Low.has_value()) {
+            return std::nullopt;
+        }
+
+        Result._Bytes.push_back((uint8_t)(High.value() << 4 | Low.value()));
+        Result._Mask.push_back(0xFF);
+    }
+
+    // A signature must contain at least one fixed byte to be anchored
+    //
+    auto FirstFixed = std::find(Result._Mask.begin(), Result._Mask.end(), 0xFF);
+    if (FirstFixed == Result._Mask.end()) {
+        return std::nullopt;
+    }
+
+    // Pick the rarest fixed byte, then the rarest one at another position
+    //
+    auto IsRarer = [&](size_t Lhs, size_t Rhs) {
+        return GetByteFrequencyRank(Result._Bytes[Lhs]) <
+               GetByteFrequencyRank(Result._Bytes[Rhs]);
+    };
+
+    Result._Anchor = FirstFixed - Result._Mask.begin();
+    for (size_t i = Result._Anchor + 1; i < Result._Bytes.size(); ++i) {
+        if (!Result.IsWildcard(i) && IsRarer(i, Result._Anchor)) {
+            Result._Anchor = i;
+        }
+    }
+
+    Result._SecondAnchor = Result._Anchor;
+    for (size_t i = 0; i < Result._Bytes.size(); ++i) {
+        if (i == Result._Anchor || Result.IsWildcard(i)) {
+            continue;
+        }
+        if (Result._SecondAnchor == Result._Anchor || IsRarer(i, Result._SecondAnchor)) {
+            Result._SecondAnchor = i;
+        }
+    }
+
+    return Result;
+}
+
+bool Signature::IsMatch(const std::byte *Address) const
+{
+    auto Data = (const uint8_t *)Address;
+    const size_t Size = _Bytes.size();
+
+    // Masked compare 8 bytes at a time, then the tail byte by byte
+    //
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= Size; i += sizeof(uint64_t)) {
+        uint64_t Value, Bytes, Mask;
+        std::memcpy(&Value, Data + i, sizeof(uint64_t));
+        std::memcpy(&Bytes, _Bytes.data() + i, sizeof(uint64_t));
+        std::memcpy(&Mask, _Mask.data() + i, sizeof(uint64_t));
+
+        if ((Value & Mask) != Bytes) {
+            return false;
+        }
+    }
+
+    for (; i < Size; ++i) {
+        if ((Data[i] & _Mask[i]) != _Bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////
+// Search kernels
+//
+// Each kernel appends the matches of `Sig` starting in [From, To) to `Matches`. The signature may
+// extend up to `Size`. `Candidates` counts the positions where both anchors matched.
+//
+
+using FnSearchKernelT = void (*)(
+    const std::byte *Begin, size_t Size, size_t From, size_t To, const Signature &Sig,
+    SigScanner::MatchesT &Matches, uint64_t &Candidates);
+
+// Returns the end of the candidate range, or `From` if there is no room for the signature.
+//
+static size_t GetCandidateEnd(size_t Size, size_t From, size_t To, const Signature &Sig)
+{
+    if (Sig.GetSize() > Size) {
+        return From;
+    }
+    return std::max(From, std::min(To, Size - Sig.GetSize() + 1));
+}
+
+static void SearchScalar(
+    const std::byte *Begin, size_t Size, size_t From, size_t To, const Signature &Sig,
+    SigScanner::MatchesT &Matches, uint64_t &Candidates)
+{
+    auto Data = (const uint8_t *)Begin;
+    const size_t End = GetCandidateEnd(Size, From, To, Sig);
+    const size_t Anchor = Sig.GetAnchor(), SecondAnchor = Sig.GetSecondAnchor();
+    const uint8_t AnchorByte = Sig.GetByte(Anchor), SecondByte = Sig.GetByte(SecondAnchor);
+
+    for (size_t Pos = From; Pos < End; ++Pos) {
+        if (Data[Pos + Anchor] != AnchorByte || Data[Pos + SecondAnchor] != SecondByte) {
+            continue;
+        }
+
+        ++Candidates;
+        if (Sig.IsMatch(Begin + Pos)) {
+            Matches.push_back(Begin + Pos);
+        }
+    }
+}
+
+#if defined SIG_SCANNER_X86_SIMD
+
+static uint32_t CountTrailingZeros(uint32_t Value)
+{
+    #if defined _MSC_VER
+    unsigned long Index;
+    _BitScanForward(&Index, Value);
+    return Index;
+    #else
+    return (uint32_t)__builtin_ctz(Value);
+    #endif
+}
+
+static void SearchSse2(
+    const std::byte *Begin, size_t Size, size_t From, size_t To, const Signature &Sig,
+    SigScanner::MatchesT &Matches, uint64_t &Candidates)
+{
+    constexpr size_t Width = sizeof(__m128i);
+
+    auto Data = (const uint8_t *)Begin;
+    const size_t End = GetCandidateEnd(Size, From, To, Sig);
+    const size_t Anchor = Sig.GetAnchor(), SecondAnchor = Sig.GetSecondAnchor();
+    const __m128i AnchorByte = _mm_set1_epi8((char)Sig.GetByte(Anchor));
+    const __m128i SecondByte = _mm_set1_epi8((char)Sig.GetByte(SecondAnchor));
+
+    size_t Pos = From;
+    for (; Pos + Width <= End; Pos += Width) {
+        __m128i First = _mm_loadu_si128((const __m128i *)(Data + Pos + Anchor));
+        __m128i Second = _mm_loadu_si128((const __m128i *)(Data + Pos + SecondAnchor));
+
+        uint32_t Mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(First, AnchorByte), _mm_cmpeq_epi8(Second, SecondByte)));
+
+        Candidates += std::popcount(Mask);
+        while (Mask != 0) {
+            size_t Candidate = Pos + CountTrailingZeros(Mask);
+            if (Sig.IsMatch(Begin + Candidate)) {
+                Matches.push_back(Begin + Candidate);
+            }
+            Mask &= Mask - 1;
+        }
+    }
+
+    SearchScalar(Begin, Size, Pos, To, Sig, Matches, Candidates);
+}
+
+SIG_SCANNER_TARGET_AVX2 static void SearchAvx2(
+    const std::byte *Begin, size_t Size, size_t From, size_t To, const Signature &Sig,
+    SigScanner::MatchesT &Matches, uint64_t &Candidates)
+{
+    constexpr size_t Width = sizeof(__m256i);
+
+    auto Data = (const uint8_t *)Begin;
+    const size_t End = GetCandidateEnd(Size, From, To, Sig);
+    const size_t Anchor = Sig.GetAnchor(), SecondAnchor = Sig.GetSecondAnchor();
+    const __m256i AnchorByte = _mm256_set1_epi8((char)Sig.GetByte(Anchor));
+    const __m256i SecondByte = _mm256_set1_epi8((char)Sig.GetByte(SecondAnchor));
+
+    size_t Pos = From;
+    for (; Pos + Width <= End; Pos += Width) {
+        __m256i First = _mm256_loadu_si256((const __m256i *)(Data + Pos + Anchor));
+        __m256i Second = _mm256_loadu_si256((const __m256i *)(Data + Pos + SecondAnchor));
+
+        uint32_t Mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(First, AnchorByte), _mm256_cmpeq_epi8(Second, SecondByte)));
+
+        Candidates += std::popcount(Mask);
+        while (Mask != 0) {
+            size_t Candidate = Pos + CountTrailingZeros(Mask);
+            if (Sig.IsMatch(Begin + Candidate)) {
+                Matches.push_back(Begin + Candidate);
+            }
+            Mask &= Mask - 1;
+        }
+    }
+
+    SearchScalar(Begin, Size, Pos, To, Sig, Matches, Candidates);
+}
+
+static bool IsAvx2Supported()
+{
+    #if defined _MSC_VER
+    int Info[4];
+    __cpuid(Info, 0);
+    if (Info[0] < 7) {
+        return false;
+    }
+
+    __cpuid(Info, 1);
+    const bool IsOsxsave = (Info[2] & (1 << 27)) != 0, IsAvx = (Info[2] & (1 << 28)) != 0;
+    if (!IsOsxsave || !IsAvx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(Info, 7, 0);
+    return (Info[1] & (1 << 5)) != 0;
+    #else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+    #endif
+}
+
+#endif
+
+static FnSearchKernelT SelectSearchKernel()
+{
+#if defined SIG_SCANNER_X86_SIMD
+    if (IsAvx2Supported()) {
+        return &SearchAvx2;
+    }
+    // SSE2 is part of the x64 baseline, and required by every CPU Telegram supports on x86
+    return &SearchSse2;
+#else
+    return &SearchScalar;
+#endif
+}
+
+static const FnSearchKernelT FnSearchKernel = SelectSearchKernel();
+
+//////////////////////////////////////////////////
+// SigScanner
+//
+
+bool SigScanner::Add(std::string_view Pattern)
+{
+    std::string Key{Pattern};
+    if (_Indices.find(Key) != _Indices.end()) {
+        return true;
+    }
+
+    auto Sig = Signature::Parse(Pattern);
+    if (!Sig.has_value()) {
+        return false;
+    }
+
+    size_t Index = _Entries.size();
+    _Entries.push_back(EntryT{std::move(Sig.value()), {}, 0});
+    _Indices.emplace(std::move(Key), Index);
+
+    return true;
+}
+
+void SigScanner::Scan(const std::byte *Begin, size_t Size, uint32_t ThreadCount)
+{
+    // Work is handed out in chunks, so that faster threads pick up more of them
+    //
+    constexpr size_t ChunkSize = 0x100000;
+
+    const size_t ChunkCount = (Size + ChunkSize - 1) / ChunkSize;
+    ThreadCount = (uint32_t)std::min<size_t>(std::max<uint32_t>(ThreadCount, 1), ChunkCount);
+
+    // Per chunk, per signature matches and candidate counts
+    //
+    std::vector<std::vector<MatchesT>> ChunkMatches(ChunkCount);
+    std::vector<std::vector<uint64_t>> ChunkCandidates(ChunkCount);
+    std::atomic<size_t> NextChunk = 0;
+
+    auto Worker = [&]() {
+        for (size_t Chunk; (Chunk = NextChunk.fetch_add(1)) < ChunkCount;) {
+            ChunkMatches[Chunk].resize(_Entries.size());
+            ChunkCandidates[Chunk].resize(_Entries.size());
+
+            // Candidates are split exactly at chunk boundaries, while the signature itself may
+            // extend into the next chunk. So no match is lost or found twice.
+            //
+            ScanChunk(
+                Begin, Size, Chunk * ChunkSize, std::min((Chunk + 1) * ChunkSize, Size),
+                ChunkMatches[Chunk], ChunkCandidates[Chunk]);
+        }
+    };
+
+    if (ThreadCount <= 1) {
+        Worker();
+    }
+    else {
+        std::vector<std::thread> Threads;
+        for (uint32_t i = 1; i < ThreadCount; ++i) {
+            Threads.emplace_back(Worker);
+        }
+        Worker();
+
+        for (std::thread &Thread : Threads) {
+            Thread.join();
+        }
+    }
+
+    // Merge in chunk order, so matches stay in ascending address order
+    //
+    for (size_t Chunk = 0; Chunk < ChunkCount; ++Chunk) {
+        for (size_t i = 0; i < _Entries.size(); ++i) {
+            const auto &Matches = ChunkMatches[Chunk][i];
+            _Entries[i].Matches.insert(_Entries[i].Matches.end(), Matches.begin(), Matches.end());
+            _Entries[i].Candidates += ChunkCandidates[Chunk][i];
+        }
+    }
+}
+
+void SigScanner::ScanChunk(
+    const std::byte *Begin, size_t Size, size_t From, size_t To,
+    std::vector<MatchesT> &Matches, std::vector<uint64_t> &Candidates) const
+{
+    // Small enough to stay in L2 while every signature runs over it
+    //
+    constexpr size_t BlockSize = 0x10000;
+
+    for (size_t BlockBegin = From; BlockBegin < To; BlockBegin += BlockSize) {
+        const size_t BlockEnd = std::min(BlockBegin + BlockSize, To);
+
+        for (size_t i = 0; i < _Entries.size(); ++i) {
+            FnSearchKernel(
+                Begin, Size, BlockBegin, BlockEnd, _Entries[i].Sig, Matches[i], Candidates[i]);
+        }
+    }
+}
+
+bool SigScanner::Contains(std::string_view Pattern) const
+{
+    return _Indices.find(std::string{Pattern}) != _Indices.end();
+}
+
+const SigScanner::MatchesT &SigScanner::GetMatches(std::string_view Pattern) const
+{
+    static const MatchesT Empty;
+
+    auto Iterator = _Indices.find(std::string{Pattern});
+    if (Iterator == _Indices.end()) {
+        return Empty;
+    }
+    return _Entries[Iterator->second].Matches;
+}
+
+uint64_t SigScanner::GetCandidateCount(std::string_view Pattern) const
+{
+    auto Iterator = _Indices.find(std::string{Pattern});
+    if (Iterator == _Indices.end()) {
+        return 0;
+    }
+    return _Entries[Iterator->second].Candidates;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+
+// A byte signature with wildcards, e.g. "41 84 C0 75 ?? 2B CA".
+//
+class Signature
+{
+public:
+    static std::optional<Signature> Parse(std::string_view Pattern);
+
+    size_t GetSize() const
+    {
+        return _Bytes.size();
+    }
+
+    uint8_t GetByte(size_t Index) const
+    {
+        return _Bytes[Index];
+    }
+
+    bool IsWildcard(size_t Index) const
+    {
+        return _Mask[Index] == 0;
+    }
+
+    // Indices of the two fixed bytes least likely to appear in x86/x64 code, used as a prefilter.
+    // They are equal if the signature contains only one fixed byte.
+    //
+    size_t GetAnchor() const
+    {
+        return _Anchor;
+    }
+
+    size_t GetSecondAnchor() const
+    {
+        return _SecondAnchor;
+    }
+
+    bool IsMatch(const std::byte *Address) const;
+
+private:
+    std::vector<uint8_t> _Bytes;
+    std::vector<uint8_t> _Mask; // 0xFF for a fixed byte, 0x00 for a wildcard
+    size_t _Anchor = 0;
+    size_t _SecondAnchor = 0;
+};
+
+// Searches a set of signatures in a single pass over memory.
+//
+// Memory is walked once in cache-sized blocks. Within a block, each signature runs a vectorized
+// kernel (AVX2 or SSE2 when the CPU supports it, scalar otherwise) that compares its two anchor
+// bytes at many positions at once, and only verifies the full signature where both match.
+//
+class SigScanner
+{
+public:
+    using MatchesT = std::vector<const std::byte *>;
+
+    // Returns false if the pattern is malformed. Adding the same pattern twice is a no-op.
+    //
+    bool Add(std::string_view Pattern);
+
+    // Appends matches of all added signatures in [Begin, Begin + Size).
+    //
+    // With `ThreadCount` > 1, the range is split into chunks scanned concurrently. Matches are
+    // merged in chunk order, so the result is identical to a single-threaded scan.
+    //
+    void Scan(const std::byte *Begin, size_t Size, uint32_t ThreadCount = 1);
+
+    bool Contains(std::string_view Pattern) const;
+
+    // Matches in ascending address order. Empty if the pattern was never added.
+    //
+    const MatchesT &GetMatches(std::string_view Pattern) const;
+
+    // Number of positions where the anchor bytes matched, i.e. how often the full signature had
+    // to be verified. For benchmarking the prefilter.
+    //
+    uint64_t GetCandidateCount(std::string_view Pattern) const;
+
+private:
+    struct EntryT
+    {
+        Signature Sig;
+        MatchesT Matches;
+        uint64_t Candidates;
+    };
+
+    std::vector<EntryT> _Entries;
+    std::unordered_map<std::string, size_t> _Indices;
+
+    void ScanChunk(
+        const std::byte *Begin, size_t Size, size_t From, size_t To,
+        std::vector<MatchesT> &Matches, std::vector<uint64_t> &Candidates) const;
+};
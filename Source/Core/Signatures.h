@@ -0,0 +1,87 @@
+#pragma once
+
+// Signatures used by the `InitDynamicData_*` resolvers.
+//
+// The comments above each resolver document where these come from.
+//
+namespace Signatures {
+
+struct NamedT
+{
+    const char *Name;
+    const char *Pattern;
+    bool IsCritical; // Needed to install the hooks, scanned first
+};
+
+#if defined PLATFORM_X86
+
+constexpr auto Malloc = "41 84 C0 75 F9 2B CA 53 56 8D 59 01 53 E8";
+constexpr auto Free = "56 E8 ?? ?? ?? ?? 59 5E 5B EB";
+constexpr auto DestroyMessage = "8B 71 ?? 89 08 85 C9 0F 84 ?? ?? ?? ?? ?? ?? ?? E8";
+constexpr auto DestroyMessageNew = "51 8B C4 89 08 8B CE E8 ?? ?? ?? ?? 80 BE ?? ?? ?? ?? 00";
+constexpr auto EditedIndex = "E8 ?? ?? ?? ?? 83 7C 87 ?? ?? 73 ?? E8";
+constexpr auto EditedIndexNew = "83 7B 04 FF 74 ?? 8B 47 08 8B 30 E8";
+constexpr auto SignedIndex = "E8 ?? ?? ?? ?? 8B 44 87 08 83 CF FF";
+constexpr auto SignedIndexNew = "85 F6 75 ?? E8 ?? ?? ?? ?? 33 D2";
+constexpr auto ReplyIndex = "E8 ?? ?? ?? ?? E8 ?? ?? ?? ?? 8B 46 08 8B 38";
+constexpr auto LangInstance = "8B 0D ?? ?? ?? ?? 03 C6 0F B7 C0 85 C9 0F 84 ?? ?? ?? ?? 8B 49";
+constexpr auto LangInstanceNew = "8B 0D ?? ?? ?? ?? 03 C6 0F B7 C0 85 C9 0F 84 ?? ?? ?? ?? 8B";
+constexpr auto ToHistoryMessageIndex =
+    "8B 49 ?? 85 C9 0F 84 ?? ?? ?? ?? 8B 01 FF 90 ?? ?? ?? ?? 85 C0";
+constexpr auto IsServiceIndex = "88 4D EF 8B 4D E4 8B 01 8B 40 ?? FF D0 84 C0";
+
+// Signatures searched in the whole main module. The critical ones are resolved together in a
+// single pass, then the others in another pass in the background.
+//
+constexpr NamedT All[] = {
+    {"Malloc", Malloc, true},
+    {"Free", Free, true},
+    {"DestroyMessage", DestroyMessage, true},
+    {"DestroyMessageNew", DestroyMessageNew, true},
+    {"EditedIndex", EditedIndex, false},
+    {"EditedIndexNew", EditedIndexNew, false},
+    {"SignedIndex", SignedIndex, false},
+    {"SignedIndexNew", SignedIndexNew, false},
+    {"ReplyIndex", ReplyIndex, false},
+    {"LangInstance", LangInstance, false},
+    {"LangInstanceNew", LangInstanceNew, false},
+    {"ToHistoryMessageIndex", ToHistoryMessageIndex, false},
+    {"IsServiceIndex", IsServiceIndex, false},
+};
+
+#elif defined PLATFORM_X64
+
+constexpr auto Malloc = "48 FF C7 80 3C 38 00 75 F7 48 8D 4F 01 E8";
+constexpr auto DestroyMessage =
+    "48 8B 5A 18 48 85 DB 0F 84 ?? ?? ?? ?? 48 8B CB E8 ?? ?? ?? ?? 80 BB ?? ?? ?? ?? 00";
+constexpr auto EditedIndex = "48 83 7C CF 10 08 73 ?? E8";
+constexpr auto EditedIndexNew = "83 7A 04 FF 74 ?? 48 8B 41 08 48 8B 18 E8";
+constexpr auto SignedIndex =
+    "E8 ?? ?? ?? ?? 4C 63 C0 4A 63 44 C3 10 83 F8 08 72 ?? 48 8B D8 48 03 5F 08 EB";
+constexpr auto ReplyIndex = "E8 ?? ?? ?? ?? 48 63 D0 48 63 44 D3 10 83 F8 08 72 6B";
+constexpr auto LangInstance = "48 8B 05 ?? ?? ?? ?? 48 8B D9 48 85 C0 0F 84 ?? ?? ?? ?? 48 8B 80";
+constexpr auto ToHistoryMessageIndex = "FF 90 ?? ?? ?? ?? C6 43 01 01";
+
+// Searched only near the `Malloc` match.
+//
+constexpr auto Free = "48 8B CB E8 ?? ?? ?? ?? EB";
+
+// Signatures searched in the whole main module. The critical ones are resolved together in a
+// single pass, then the others in another pass in the background.
+//
+constexpr NamedT All[] = {
+    {"Malloc", Malloc, true},
+    {"DestroyMessage", DestroyMessage, true},
+    {"EditedIndex", EditedIndex, false},
+    {"EditedIndexNew", EditedIndexNew, false},
+    {"SignedIndex", SignedIndex, false},
+    {"ReplyIndex", ReplyIndex, false},
+    {"LangInstance", LangInstance, false},
+    {"ToHistoryMessageIndex", ToHistoryMessageIndex, false},
+};
+
+#else
+    #error "Unimplemented."
+#endif
+
+} // namespace Signatures
@@ -1,9 +1,19 @@
 ﻿#include "Telegram.h"
+#include "ResolvedLayout.h"
 
-#include "Logger.h"
-#include "Utils.h"
-#include "IRuntime.h"
-#include "IAntiRevoke.h"
+#if defined OS_WIN
+    #include "Logger.h"
+    #include "Utils.h"
+    #include "IAntiRevoke.h"
+#endif
+
+// Only valid once `IRuntime::WaitDeferredData()` has succeeded, the hooks check it before touching
+// any message.
+//
+static const ResolvedLayoutT &GetLayout()
+{
+    return *ResolvedLayout::Get();
+}
 
 //////////////////////////////////////////////////
 // Object
@@ -49,13 +59,7 @@ void Object::SetWidth(int32_t Value)
 
 Media *HistoryViewElement::GetMedia()
 {
-#if defined PLATFORM_X86
-    return *(Media **)((uintptr_t)this + 0x24);
-#elif defined PLATFORM_X64
-    return *(Media **)((uintptr_t)this + 0x38);
-#else
-    #error "Unimplemented."
-#endif
+    return *(Media **)((uintptr_t)this + GetLayout().Offset.ElementMedia);
 }
 
 //////////////////////////////////////////////////
@@ -64,13 +68,7 @@ Media *HistoryViewElement::GetMedia()
 
 QtString *HistoryMessageEdited::GetTimeText()
 {
-#if defined PLATFORM_X86
-    return (QtString *)((uintptr_t)this + 0x10);
-#elif defined PLATFORM_X64
-    return (QtString *)((uintptr_t)this + 0x18);
-#else
-    #error "Unimplemented."
-#endif
+    return (QtString *)((uintptr_t)this + GetLayout().Offset.EditedTimeText);
 }
 
 //////////////////////////////////////////////////
@@ -79,7 +77,7 @@ QtString *HistoryMessageEdited::GetTimeText()
 
 QtString *HistoryMessageSigned::GetTimeText()
 {
-    return (QtString *)((uintptr_t)this + IRuntime::GetInstance().GetData().Offset.SignedTimeText);
+    return (QtString *)((uintptr_t)this + GetLayout().Offset.SignedTimeText);
 }
 
 //////////////////////////////////////////////////
@@ -88,7 +86,7 @@ QtString *HistoryMessageSigned::GetTimeText()
 
 int32_t &HistoryMessageReply::MaxReplyWidth()
 {
-    return *(int32_t *)((uintptr_t)this + IRuntime::GetInstance().GetData().Offset.MaxReplyWidth);
+    return *(int32_t *)((uintptr_t)this + GetLayout().Offset.MaxReplyWidth);
 }
 
 //////////////////////////////////////////////////
@@ -114,10 +112,12 @@ int32_t &HistoryMessageReply::MaxReplyWidth()
 //     return *(PeerData**)((uintptr_t)this + IRuntime::GetInstance().GetData().Offset.HistoryPeer);
 // }
 
+#if defined OS_WIN
 void History::OnDestroyMessage(HistoryMessage *pMessage)
 {
     IAntiRevoke::GetInstance().OnDestroyMessage(this, pMessage);
 }
+#endif
 
 //////////////////////////////////////////////////
 // HistoryMessage
@@ -129,28 +129,31 @@ bool HistoryMessage::IsMessage()
     // It will cause a memory access crash, so we need to filter it out.
     //
 
-    auto RuntimeIns = IRuntime::GetInstance();
-    const auto FileVersion = RuntimeIns.GetFileVersion();
-    const auto &Index = RuntimeIns.GetData().Index;
-
-    // ver < 3.2.5
-    if (FileVersion < 3002005) {
-        // HistoryMessage *HistoryItem::toHistoryMessage()
-        //
-        using FnToHistoryMessageT = HistoryMessage *(*)(HistoryMessage * This);
-        return Utils::CallVirtual<FnToHistoryMessageT>(this, Index.ToHistoryMessage)(this) !=
-               nullptr;
-    }
-    // ver >= 3.2.5
-    else if (FileVersion >= 3002005) {
-        // bool HistoryItem::isService() const
-        //
-        using FnIsServiceT = bool (*)(HistoryMessage * This);
-        return !Utils::CallVirtual<FnIsServiceT>(this, Index.IsService)(this);
-    }
-    else {
-        return false;
+    const auto &Layout = GetLayout();
+    return Layout.FnIsMessage(this, Layout.Index.IsService);
+}
+
+// Walking the components needs SEH, see `Safe::TryExcept()`
+//
+#if defined OS_WIN
+struct RuntimeComposerMetadata
+{
+    size_t size;
+    size_t align;
+    size_t offsets[64];
+    int last;
+};
+
+// Not guarded, the callers are responsible for catching exceptions.
+//
+static void *GetComponentUnsafe(void **data, uint32_t index)
+{
+    auto metaData = (RuntimeComposerMetadata *)(*data);
+    auto offset = metaData->offsets[index];
+    if (offset >= sizeof(RuntimeComposerMetadata *)) {
+        return (void *)((uintptr_t)data + offset);
     }
+    return nullptr;
 }
 
 template <class CompT>
@@ -160,20 +163,8 @@ CompT *HistoryMessage::GetComponent(uint32_t index)
 
     Safe::TryExcept(
         [&]() {
-            struct RuntimeComposerMetadata
-            {
-                size_t size;
-                size_t align;
-                size_t offsets[64];
-                int last;
-            };
-
             auto data = *(void ***)((uintptr_t)this + 8);
-            auto metaData = (RuntimeComposerMetadata *)(*data);
-            auto offset = metaData->offsets[index];
-            if (offset >= sizeof(RuntimeComposerMetadata *)) {
-                result = (CompT *)((uintptr_t)data + offset);
-            }
+            result = (CompT *)GetComponentUnsafe(data, index);
         },
         [&](ULONG ExceptionCode) {
             LOG(Warn,
@@ -186,21 +177,41 @@ CompT *HistoryMessage::GetComponent(uint32_t index)
 
 HistoryMessageEdited *HistoryMessage::GetEdited()
 {
-    return GetComponent<HistoryMessageEdited>(
-        IRuntime::GetInstance().GetData().Function.EditedIndex());
+    return GetComponent<HistoryMessageEdited>(GetLayout().ComponentIndex.Edited);
 }
 
 HistoryMessageSigned *HistoryMessage::GetSigned()
 {
-    return GetComponent<HistoryMessageSigned>(
-        IRuntime::GetInstance().GetData().Function.SignedIndex());
+    return GetComponent<HistoryMessageSigned>(GetLayout().ComponentIndex.Signed);
 }
 
 HistoryMessageReply *HistoryMessage::GetReply()
 {
-    return GetComponent<HistoryMessageReply>(
-        IRuntime::GetInstance().GetData().Function.ReplyIndex());
+    return GetComponent<HistoryMessageReply>(GetLayout().ComponentIndex.Reply);
+}
+
+HistoryMessageComponentsT HistoryMessage::GetComponents()
+{
+    HistoryMessageComponentsT result;
+    const auto &index = GetLayout().ComponentIndex;
+
+    Safe::TryExcept(
+        [&]() {
+            auto data = *(void ***)((uintptr_t)this + 8);
+            result.pEdited = (HistoryMessageEdited *)GetComponentUnsafe(data, index.Edited);
+            result.pSigned = (HistoryMessageSigned *)GetComponentUnsafe(data, index.Signed);
+            result.pReply = (HistoryMessageReply *)GetComponentUnsafe(data, index.Reply);
+        },
+        [&](ULONG ExceptionCode) {
+            LOG(Warn,
+                "Function: [" __FUNCTION__ "] An exception was caught. Code: {:#x}, Address: {}",
+                ExceptionCode, (void *)this);
+            result = {};
+        });
+
+    return result;
 }
+#endif
 
 // History* HistoryMessage::GetHistory()
 // {
@@ -242,22 +253,21 @@ HistoryMessageReply *HistoryMessage::GetReply()
 
 HistoryViewElement *HistoryMessage::GetMainView()
 {
-    return *(
-        HistoryViewElement **)((uintptr_t)this + IRuntime::GetInstance().GetData().Offset.MainView);
+    return *(HistoryViewElement **)((uintptr_t)this + GetLayout().Offset.MainView);
 }
 
 QtString *HistoryMessage::GetTimeText()
 {
-    return (QtString *)((uintptr_t)this + IRuntime::GetInstance().GetData().Offset.TimeText);
+    return (QtString *)((uintptr_t)this + GetLayout().Offset.TimeText);
 }
 
 int32_t HistoryMessage::GetTimeWidth()
 {
-    return *(int32_t *)((uintptr_t)this + IRuntime::GetInstance().GetData().Offset.TimeWidth);
+    return *(int32_t *)((uintptr_t)this + GetLayout().Offset.TimeWidth);
 }
 void HistoryMessage::SetTimeWidth(int32_t Value)
 {
-    *(int32_t *)((uintptr_t)this + IRuntime::GetInstance().GetData().Offset.TimeWidth) = Value;
+    *(int32_t *)((uintptr_t)this + GetLayout().Offset.TimeWidth) = Value;
 }
 
 //////////////////////////////////////////////////
@@ -266,44 +276,20 @@ void HistoryMessage::SetTimeWidth(int32_t Value)
 
 QtString *LanguageInstance::GetId()
 {
-#if defined PLATFORM_X86
-    return (QtString *)((uintptr_t)this + 0x4);
-#elif defined PLATFORM_X64
-    return (QtString *)((uintptr_t)this + 0x8);
-#else
-    #error "Unimplemented."
-#endif
+    return (QtString *)((uintptr_t)this + GetLayout().Offset.LangId);
 }
 
 QtString *LanguageInstance::GetPluralId()
 {
-#if defined PLATFORM_X86
-    return (QtString *)((uintptr_t)this + 0x8);
-#elif defined PLATFORM_X64
-    return (QtString *)((uintptr_t)this + 0x10);
-#else
-    #error "Unimplemented."
-#endif
+    return (QtString *)((uintptr_t)this + GetLayout().Offset.LangPluralId);
 }
 
 QtString *LanguageInstance::GetName()
 {
-#if defined PLATFORM_X86
-    return (QtString *)((uintptr_t)this + 0x14);
-#elif defined PLATFORM_X64
-    return (QtString *)((uintptr_t)this + 0x28);
-#else
-    #error "Unimplemented."
-#endif
+    return (QtString *)((uintptr_t)this + GetLayout().Offset.LangName);
 }
 
 QtString *LanguageInstance::GetNativeName()
 {
-#if defined PLATFORM_X86
-    return (QtString *)((uintptr_t)this + 0x18);
-#elif defined PLATFORM_X64
-    return (QtString *)((uintptr_t)this + 0x30);
-#else
-    #error "Unimplemented."
-#endif
+    return (QtString *)((uintptr_t)this + GetLayout().Offset.LangNativeName);
 }
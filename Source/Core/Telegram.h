@@ -102,9 +102,21 @@ public:
 //
 // };
 
+struct HistoryMessageComponentsT
+{
+    HistoryMessageEdited *pEdited = nullptr;
+    HistoryMessageSigned *pSigned = nullptr;
+    HistoryMessageReply *pReply = nullptr;
+};
+
 class HistoryMessage /* : public HistoryItem */
 {
 public:
+    // An `IsMessage()` implementation for a range of Telegram versions, selected once the layout
+    // is resolved. `Index` is the virtual call index the implementation calls.
+    //
+    using FnIsMessageT = bool (*)(HistoryMessage *This, uint32_t Index);
+
     bool IsMessage();
 
     template <class CompT>
@@ -114,6 +126,10 @@ public:
     HistoryMessageSigned *GetSigned();
     HistoryMessageReply *GetReply();
 
+    // All of the above in a single walk of the component metadata.
+    //
+    HistoryMessageComponentsT GetComponents();
+
     // History* GetHistory();
     // Media* GetMedia();
     // bool IsSticker();
@@ -40,8 +40,11 @@ std::string GetCurrentName()
 
 uint32_t GetCurrentVersion()
 {
-    std::string FullName = GetCurrentFullNameA();
+    return GetVersion(GetCurrentFullNameA());
+}
 
+uint32_t GetVersion(const std::string &FullName)
+{
     ULONG InfoSize = GetFileVersionInfoSizeA(FullName.c_str(), nullptr);
     if (InfoSize == 0) {
         return 0;
@@ -139,8 +142,8 @@ std::string UnicodeToAnsi(const std::wstring &String)
 namespace Internet {
 
 bool HttpRequest(
-    std::string &Response, uint32_t &Status, const std::string &HttpVerb,
-    const std::string &HostName, const std::string &ObjectName,
+    std::string &Response, uint32_t &Status, const std::string &HttpVerb, const ServerT &Server,
+    const std::string &ObjectName,
     const std::vector<std::pair<std::string, std::string>> &Headers, const std::string &PostData)
 {
     if (HttpVerb != "GET" && HttpVerb != "POST") {
@@ -177,7 +180,7 @@ bool HttpRequest(
         }
 
         hConnect = InternetConnectA(
-            hInternet, HostName.c_str(), INTERNET_DEFAULT_HTTPS_PORT, nullptr, nullptr,
+            hInternet, Server.HostName.c_str(), Server.Port, nullptr, nullptr,
             INTERNET_SERVICE_HTTP, 0, 0);
         if (hConnect == nullptr) {
             break;
@@ -185,7 +188,9 @@ bool HttpRequest(
 
         hRequest = HttpOpenRequestA(
             hConnect, HttpVerb.c_str(), ObjectName.c_str(), "HTTP/1.1", nullptr, nullptr,
-            INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_RELOAD | INTERNET_FLAG_SECURE, 0);
+            INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_RELOAD |
+                (Server.IsSecure ? INTERNET_FLAG_SECURE : 0),
+            0);
         if (hRequest == nullptr) {
             break;
         }
@@ -5,27 +5,12 @@
 #include <functional>
 #include <Windows.h>
 
-class NonCopyable
-{
-protected:
-    NonCopyable() = default;
-
-    NonCopyable(const NonCopyable &) = delete;
-    NonCopyable &operator=(const NonCopyable &) = delete;
-};
-
-class NonMovable
-{
-protected:
-    NonMovable() = default;
-
-    NonMovable(NonMovable &&) = delete;
-    NonMovable &operator=(NonMovable &&) = delete;
-};
+#include "NonCopyable.h"
 
 namespace File {
 
 uint32_t GetCurrentVersion();
+uint32_t GetVersion(const std::string &FullName);
 std::string GetCurrentName();
 
 } // namespace File
@@ -48,9 +33,16 @@ std::string UnicodeToAnsi(const std::wstring &String);
 
 namespace Internet {
 
+struct ServerT
+{
+    std::string HostName;
+    uint16_t Port = 443;
+    bool IsSecure = true;
+};
+
 bool HttpRequest(
-    std::string &Response, uint32_t &Status, const std::string &HttpVerb,
-    const std::string &HostName, const std::string &ObjectName,
+    std::string &Response, uint32_t &Status, const std::string &HttpVerb, const ServerT &Server,
+    const std::string &ObjectName,
     const std::vector<std::pair<std::string, std::string>> &Headers,
     const std::string &PostData = std::string{});
 
@@ -104,10 +96,4 @@ void *GetFunctionAddress(FnT Function)
     return Data.Address;
 }
 
-template <typename FnT>
-FnT CallVirtual(void *Base, uint32_t Index)
-{
-    return (FnT)(((void ***)Base)[0][Index]);
-}
-
 } // namespace Utils
\ No newline at end of file
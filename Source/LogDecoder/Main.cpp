@@ -0,0 +1,179 @@
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/pattern_formatter.h>
+#include <spdlog/details/log_msg.h>
+
+#include "BinaryLog.h"
+#include "LogArchive.h"
+
+// Turns an `ArLog.bin` written with `TAR_BINARY_LOG` back into the text `ArLog.txt` would have
+// contained, see `BinaryLog.h`. The text is printed to stdout.
+//
+// Compressed segments of either log are decompressed first, see `LogArchive.h`. Text is printed
+// as it is.
+//
+// A truncated last record, left by a process ending before the writer flushed, is reported as
+// malformed, everything before it is still printed.
+//
+// Usage: TAR-LogDecoder-<arch>.exe <ArLog.bin|ArLog.*.bin.lznt1|ArLog.*.txt.lznt1>
+//
+
+class Decoder
+{
+public:
+    Decoder(std::string Data) : _Data{std::move(Data)} {}
+
+    // Returns false if the file is malformed, the records before the error are printed anyway.
+    //
+    bool Run()
+    {
+        if (_Data.size() < sizeof(BinaryLog::Magic) ||
+            std::string_view{_Data.data(), sizeof(BinaryLog::Magic)} !=
+                std::string_view{BinaryLog::Magic, sizeof(BinaryLog::Magic)})
+        {
+            std::fprintf(stderr, "Not a binary log file.\n");
+            return false;
+        }
+        _Position = sizeof(BinaryLog::Magic);
+
+        while (_Position < _Data.size()) {
+            bool Result;
+            switch ((BinaryLog::RecordType)_Data[_Position]) {
+            case BinaryLog::RecordType::String:
+                Result = ReadString();
+                break;
+            case BinaryLog::RecordType::Message:
+                Result = ReadMessage();
+                break;
+            default:
+                Result = false;
+                break;
+            }
+
+            if (!Result) {
+                std::fprintf(stderr, "Malformed record at offset %zu.\n", _Position);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    std::string _Data;
+    size_t _Position = 0;
+    std::unordered_map<uint32_t, std::string> _Strings;
+    spdlog::pattern_formatter _Formatter;
+
+    template <class T>
+    std::optional<T> ReadHeader()
+    {
+        if (_Data.size() - _Position < sizeof(T)) {
+            return std::nullopt;
+        }
+
+        T Header;
+        std::memcpy(&Header, _Data.data() + _Position, sizeof(T));
+        return Header;
+    }
+
+    bool ReadString()
+    {
+        auto Header = ReadHeader<BinaryLog::StringHeaderT>();
+        if (!Header.has_value() || _Data.size() - _Position - sizeof(*Header) < Header->Size) {
+            return false;
+        }
+
+        _Position += sizeof(*Header);
+        _Strings[Header->Id] = _Data.substr(_Position, Header->Size);
+        _Position += Header->Size;
+        return true;
+    }
+
+    bool ReadMessage()
+    {
+        auto Header = ReadHeader<BinaryLog::MessageHeaderT>();
+        if (!Header.has_value() || _Data.size() - _Position - sizeof(*Header) < Header->ArgsSize) {
+            return false;
+        }
+
+        auto Format = _Strings.find(Header->FormatId);
+        auto File = _Strings.find(Header->FileId);
+        auto Function = _Strings.find(Header->FunctionId);
+        if (Format == _Strings.end() || File == _Strings.end() || Function == _Strings.end()) {
+            return false;
+        }
+
+        _Position += sizeof(*Header);
+        const auto pArgs = (const std::byte *)_Data.data() + _Position;
+        _Position += Header->ArgsSize;
+
+        std::string Payload;
+        try {
+            auto Formatted = BinaryLog::FormatArgs(Format->second, pArgs, Header->ArgsSize);
+            if (!Formatted.has_value()) {
+                return false;
+            }
+            Payload = std::move(Formatted.value());
+        }
+        catch (const std::exception &Exception) {
+            Payload = fmt::format("Failed to format \"{}\". {}", Format->second, Exception.what());
+        }
+
+        spdlog::details::log_msg Message{
+            spdlog::log_clock::time_point{std::chrono::duration_cast<spdlog::log_clock::duration>(
+                std::chrono::nanoseconds{Header->Time})},
+            spdlog::source_loc{File->second.c_str(), (int)Header->Line, Function->second.c_str()},
+            BinaryLog::LoggerName, (spdlog::level::level_enum)Header->Level, Payload};
+        Message.thread_id = Header->ThreadId;
+
+        spdlog::memory_buf_t Text;
+        _Formatter.format(Message, Text);
+        std::fwrite(Text.data(), 1, Text.size(), stdout);
+        return true;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s <ArLog.bin|ArLog.*.lznt1>\n", argv[0]);
+        return 2;
+    }
+
+    std::ifstream File{argv[1], std::ios::binary};
+    if (!File) {
+        std::fprintf(stderr, "Failed to open \"%s\".\n", argv[1]);
+        return 1;
+    }
+
+    std::string Data{std::istreambuf_iterator<char>{File}, {}};
+
+    if (LogArchive::IsArchive(Data)) {
+        auto Decompressed = LogArchive::Decompress(Data);
+        if (!Decompressed.has_value()) {
+            std::fprintf(stderr, "Failed to decompress \"%s\".\n", argv[1]);
+            return 1;
+        }
+        Data = std::move(Decompressed.value());
+
+        const std::string_view Magic{BinaryLog::Magic, sizeof(BinaryLog::Magic)};
+        if (std::string_view{Data}.substr(0, Magic.size()) != Magic) {
+            std::fwrite(Data.data(), 1, Data.size(), stdout);
+            return 0;
+        }
+    }
+
+    Decoder Decoder{std::move(Data)};
+    return Decoder.Run() ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <optional>
+#include <functional>
+
+#include "SigScanner.h"
+#include "Signatures.h"
+#include "Logger.h"
+
+using json = nlohmann::json;
+
+struct RegionT
+{
+    const std::byte *Begin;
+    size_t Size;
+};
+
+// The same regions `IRuntime` scans
+//
+static std::vector<RegionT> GetCodeRegions(const PeImage &Image)
+{
+    std::vector<RegionT> Result;
+
+    if (auto pText = Image.FindSection(".text"); pText != nullptr) {
+        Result.push_back({Image.GetSectionBegin(*pText), Image.GetSectionSize(*pText)});
+    }
+    else {
+        for (const auto &Section : Image.GetSections()) {
+            if ((Section.Characteristics & PeImage::SectionExecute) != 0) {
+                Result.push_back({Image.GetSectionBegin(Section), Image.GetSectionSize(Section)});
+            }
+        }
+    }
+    return Result;
+}
+
+// Returns the fastest of `Runs` calls in microseconds
+//
+static double MeasureBest(uint32_t Runs, const std::function<void()> &Callback)
+{
+    using Clock = std::chrono::steady_clock;
+
+    double Best = 0;
+    for (uint32_t i = 0; i < std::max(Runs, 1u); ++i) {
+        auto Begin = Clock::now();
+        Callback();
+        double Elapsed = std::chrono::duration<double, std::micro>(Clock::now() - Begin).count();
+
+        if (i == 0 || Elapsed < Best) {
+            Best = Elapsed;
+        }
+    }
+    return Best;
+}
+
+json BenchSignatures(const PeImage &Image, uint32_t Runs)
+{
+    const auto Regions = GetCodeRegions(Image);
+
+    uint64_t Bytes = 0;
+    for (const auto &Region : Regions) {
+        Bytes += Region.Size;
+    }
+
+    json Result;
+    Result["runs"] = Runs;
+    Result["bytes"] = Bytes;
+
+    // Each signature on its own
+    //
+    for (const auto &[Name, Pattern, IsCritical] : Signatures::All) {
+        SigScanner Scanner;
+        double Time = MeasureBest(Runs, [&]() {
+            Scanner = SigScanner{};
+            Scanner.Add(Pattern);
+            for (const auto &Region : Regions) {
+                Scanner.Scan(Region.Begin, Region.Size);
+            }
+        });
+
+        auto &Entry = Result["signatures"][Name];
+        Entry["time_us"] = Time;
+        Entry["candidates"] = Scanner.GetCandidateCount(Pattern);
+        Entry["matches"] = Scanner.GetMatches(Pattern).size();
+    }
+
+    // All signatures in a single pass
+    //
+    Result["single_pass_us"] = MeasureBest(Runs, [&]() {
+        SigScanner Scanner;
+        for (const auto &[Name, Pattern, IsCritical] : Signatures::All) {
+            Scanner.Add(Pattern);
+        }
+        for (const auto &Region : Regions) {
+            Scanner.Scan(Region.Begin, Region.Size);
+        }
+    });
+
+    return Result;
+}
+
+static std::optional<std::vector<json>> ReadJsonLines(const std::string &FileName)
+{
+    std::ifstream File{FileName};
+    if (!File.good()) {
+        LOG(Warn, "[Resolver] Failed to open \"{}\"", FileName);
+        return std::nullopt;
+    }
+
+    std::vector<json> Result;
+    for (std::string Line; std::getline(File, Line);) {
+        if (Line.empty()) {
+            continue;
+        }
+
+        auto Object = json::parse(Line, nullptr, false);
+        if (Object.is_discarded() || !Object.contains("bench")) {
+            LOG(Warn, "[Resolver] \"{}\" is not an output of --bench.", FileName);
+            return std::nullopt;
+        }
+        Result.push_back(std::move(Object));
+    }
+    return Result;
+}
+
+static std::string FormatDelta(double Old, double New)
+{
+    if (Old == 0) {
+        return "n/a";
+    }
+
+    char Buffer[32];
+    std::snprintf(Buffer, sizeof(Buffer), "%+.1f%%", (New - Old) / Old * 100);
+    return Buffer;
+}
+
+bool DiffBenchRuns(const std::string &OldFileName, const std::string &NewFileName)
+{
+    auto OldRuns = ReadJsonLines(OldFileName), NewRuns = ReadJsonLines(NewFileName);
+    if (!OldRuns.has_value() || !NewRuns.has_value()) {
+        return false;
+    }
+
+    for (const json &New : NewRuns.value()) {
+        auto Old = std::find_if(OldRuns->begin(), OldRuns->end(), [&](const json &Run) {
+            return Run["file"] == New["file"];
+        });
+        if (Old == OldRuns->end()) {
+            std::printf("%s: not in the old run\n\n", New["file"].get<std::string>().c_str());
+            continue;
+        }
+
+        const json &OldBench = (*Old)["bench"], &NewBench = New["bench"];
+
+        std::printf("%s\n", New["file"].get<std::string>().c_str());
+        std::printf(
+            "  %-24s %12s %12s %8s %24s %16s\n", "signature", "old (us)", "new (us)", "delta",
+            "candidates", "matches");
+
+        for (const auto &[Name, NewEntry] : NewBench["signatures"].items()) {
+            if (!OldBench["signatures"].contains(Name)) {
+                std::printf("  %-24s not in the old run\n", Name.c_str());
+                continue;
+            }
+
+            const json &OldEntry = OldBench["signatures"][Name];
+            const double OldTime = OldEntry["time_us"], NewTime = NewEntry["time_us"];
+
+            std::printf(
+                "  %-24s %12.1f %12.1f %8s %10llu -> %-10llu %6llu -> %-6llu\n", Name.c_str(),
+                OldTime, NewTime, FormatDelta(OldTime, NewTime).c_str(),
+                OldEntry["candidates"].get<unsigned long long>(),
+                NewEntry["candidates"].get<unsigned long long>(),
+                OldEntry["matches"].get<unsigned long long>(),
+                NewEntry["matches"].get<unsigned long long>());
+        }
+
+        const double OldTime = OldBench["single_pass_us"], NewTime = NewBench["single_pass_us"];
+        std::printf(
+            "  %-24s %12.1f %12.1f %8s\n\n", "(single pass)", OldTime, NewTime,
+            FormatDelta(OldTime, NewTime).c_str());
+    }
+
+    return true;
+}
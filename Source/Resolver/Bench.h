@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "PeImage.h"
+
+// Scans the code of an image once per signature of `Signatures::All`, and once with all of them
+// in a single pass, `Runs` times each. Reports the fastest run, the bytes scanned, the anchor
+// candidates verified and the final matches of each signature.
+//
+// `Image` must be parsed from memory laid out by `MapImage()`.
+//
+nlohmann::json BenchSignatures(const PeImage &Image, uint32_t Runs);
+
+// Prints a per-signature comparison of two outputs of `--bench`, matched by file name.
+//
+bool DiffBenchRuns(const std::string &OldFileName, const std::string &NewFileName);
@@ -0,0 +1,106 @@
+#include "Image.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Logger.h"
+
+MappedFile::~MappedFile()
+{
+    if (_View != nullptr) {
+        UnmapViewOfFile(_View);
+    }
+    if (_hMapping != nullptr) {
+        CloseHandle(_hMapping);
+    }
+    if (_hFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(_hFile);
+    }
+}
+
+bool MappedFile::Open(const std::string &FileName)
+{
+    _hFile = CreateFileA(
+        FileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_hFile == INVALID_HANDLE_VALUE) {
+        LOG(Warn, "[Resolver] CreateFileA() failed. LastError: {}", ::GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER FileSize;
+    if (!GetFileSizeEx(_hFile, &FileSize) || FileSize.QuadPart == 0 ||
+        (uint64_t)FileSize.QuadPart > SIZE_MAX)
+    {
+        LOG(Warn, "[Resolver] Invalid file size.");
+        return false;
+    }
+
+    _hMapping = CreateFileMappingA(_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_hMapping == nullptr) {
+        LOG(Warn, "[Resolver] CreateFileMappingA() failed. LastError: {}", ::GetLastError());
+        return false;
+    }
+
+    _View = (const std::byte *)MapViewOfFile(_hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (_View == nullptr) {
+        LOG(Warn, "[Resolver] MapViewOfFile() failed. LastError: {}", ::GetLastError());
+        return false;
+    }
+
+    _Size = (size_t)FileSize.QuadPart;
+    return true;
+}
+
+ImageMemoryT MapImage(const MappedFile &ImageFile, const PeImage &FileImage)
+{
+    if (FileImage.Is64Bit() != (sizeof(void *) == 8)) {
+        LOG(Warn, "[Resolver] The image platform does not match the resolver's, use the {} one.",
+            FileImage.Is64Bit() ? "x64" : "x86");
+        return nullptr;
+    }
+
+    const size_t ImageSize = FileImage.GetSizeOfImage();
+    ImageMemoryT Memory{
+        (std::byte *)VirtualAlloc(nullptr, ImageSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE)};
+    if (Memory == nullptr) {
+        LOG(Warn, "[Resolver] VirtualAlloc() failed. LastError: {}", ::GetLastError());
+        return nullptr;
+    }
+
+    std::memcpy(
+        Memory.get(), ImageFile.GetData(),
+        std::min<size_t>({FileImage.GetSizeOfHeaders(), ImageSize, ImageFile.GetSize()}));
+
+    for (const auto &Section : FileImage.GetSections()) {
+        const size_t Size = FileImage.GetSectionSize(Section);
+        if (Section.VirtualAddress > ImageSize || Size > ImageSize - Section.VirtualAddress) {
+            LOG(Warn, "[Resolver] Section \"{}\" is out of the image.", Section.Name);
+            return nullptr;
+        }
+        std::memcpy(
+            Memory.get() + Section.VirtualAddress, FileImage.GetSectionBegin(Section), Size);
+    }
+
+    auto Relocations = FileImage.GetRelocations();
+    if (!Relocations.has_value()) {
+        LOG(Warn, "[Resolver] The base relocation table is malformed.");
+        return nullptr;
+    }
+
+    const uintptr_t Delta = (uintptr_t)Memory.get() - (uintptr_t)FileImage.GetImageBase();
+
+    for (uint32_t Rva : Relocations.value()) {
+        if (Rva > ImageSize - sizeof(uintptr_t)) {
+            LOG(Warn, "[Resolver] Relocation out of the image. RVA: {:#x}", Rva);
+            return nullptr;
+        }
+
+        uintptr_t Value;
+        std::memcpy(&Value, Memory.get() + Rva, sizeof(Value));
+        Value += Delta;
+        std::memcpy(Memory.get() + Rva, &Value, sizeof(Value));
+    }
+
+    return Memory;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <Windows.h>
+
+#include "PeImage.h"
+#include "Utils.h"
+
+// A file mapped read-only.
+//
+class MappedFile : NonCopyable
+{
+public:
+    ~MappedFile();
+
+    bool Open(const std::string &FileName);
+
+    const std::byte *GetData() const
+    {
+        return _View;
+    }
+
+    size_t GetSize() const
+    {
+        return _Size;
+    }
+
+private:
+    HANDLE _hFile = INVALID_HANDLE_VALUE;
+    HANDLE _hMapping = nullptr;
+    const std::byte *_View = nullptr;
+    size_t _Size = 0;
+};
+
+struct VirtualFreeDeleter
+{
+    void operator()(std::byte *Address) const
+    {
+        VirtualFree(Address, 0, MEM_RELEASE);
+    }
+};
+
+using ImageMemoryT = std::unique_ptr<std::byte, VirtualFreeDeleter>;
+
+// Lays out the sections at their RVAs in private memory and applies the base relocations against
+// it, so absolute addresses in code point into the copy. The file itself is never written.
+//
+ImageMemoryT MapImage(const MappedFile &ImageFile, const PeImage &FileImage);
@@ -0,0 +1,193 @@
+#include <Windows.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <algorithm>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include "IRuntime.h"
+#include "PeImage.h"
+#include "Utils.h"
+#include "Image.h"
+#include "Bench.h"
+#include "Layouts.h"
+
+using json = nlohmann::json;
+
+// Runs the `IRuntime` resolvers against Telegram.exe files on disk, without launching them.
+//
+// Each file is mapped read-only, laid out in private memory as the loader would, and relocated to
+// that memory. The resolved data of each file is printed to stdout as one line of JSON, logs go
+// to stderr.
+//
+// With `--bench`, every signature is also benchmarked on its own, see `BenchSignatures()`. Two such
+// outputs can be compared with `--diff`.
+//
+// Usage: TAR-Resolver-<arch>.exe [--bench [--runs <N>]] <Telegram.exe>...
+//        TAR-Resolver-<arch>.exe --diff <old.jsonl> <new.jsonl>
+//
+
+json DumpData(const IRuntime &Runtime)
+{
+    const auto &Data = Runtime.GetData();
+    auto ToRva = [&](const void *Address) {
+        return (uint32_t)((const std::byte *)Address - Runtime.GetModuleBase());
+    };
+
+    json Result;
+
+    auto Offset = Data.Offset;
+    for (const auto &[Name, pValue] : Layouts::GetFields(Offset)) {
+        Result["offset"][Name] = *pValue;
+    }
+
+    Result["index"] = Data.Index.ToHistoryMessage;
+
+    Result["function"]["malloc"] = ToRva(Data.Function.Malloc);
+    Result["function"]["free"] = ToRva(Data.Function.Free);
+    Result["function"]["edited_index"] = ToRva(Data.Function.EditedIndex);
+    Result["function"]["signed_index"] = ToRva(Data.Function.SignedIndex);
+    Result["function"]["reply_index"] = ToRva(Data.Function.ReplyIndex);
+
+    Result["address"]["destroy_message_caller"] = ToRva(Data.Address.FnDestroyMessageCaller);
+
+    const auto &LangLocator = Runtime.GetLangLocator();
+    Result["lang_instance"]["core_app_rva"] = ToRva((const void *)LangLocator.pCoreAppInstance);
+    Result["lang_instance"]["offset"] = LangLocator.Offset;
+
+    return Result;
+}
+
+bool Resolve(const std::string &FileName, uint32_t BenchRuns, json &Result)
+{
+    using namespace std::chrono;
+
+    Result["file"] = FileName;
+
+    MappedFile ImageFile;
+    if (!ImageFile.Open(FileName)) {
+        return false;
+    }
+
+    auto FileImage =
+        PeImage::Parse(ImageFile.GetData(), ImageFile.GetSize(), PeImage::Layout::File);
+    if (!FileImage.has_value()) {
+        LOG(Warn, "[Resolver] Not a valid PE file.");
+        return false;
+    }
+
+    auto LoadBegin = steady_clock::now();
+    auto Memory = MapImage(ImageFile, FileImage.value());
+    if (Memory == nullptr) {
+        return false;
+    }
+    Result["timing_us"]["MapImage"] =
+        duration_cast<microseconds>(steady_clock::now() - LoadBegin).count();
+
+    // Before resolving, a release the resolvers fail on is the most interesting to benchmark
+    //
+    if (BenchRuns != 0) {
+        auto Image =
+            PeImage::Parse(Memory.get(), FileImage->GetSizeOfImage(), PeImage::Layout::Mapped);
+        Result["bench"] = BenchSignatures(Image.value(), BenchRuns);
+    }
+
+    auto FileVersion = File::GetVersion(FileName);
+    Result["file_version"] = FileVersion;
+
+    // A fresh instance per file, the singleton belongs to the injected module
+    //
+    auto Runtime = std::make_unique<IRuntime>();
+    if (!Runtime->Initialize(Memory.get(), FileImage->GetSizeOfImage(), FileVersion)) {
+        return false;
+    }
+
+    if (!Runtime->InitFixedData()) {
+        LOG(Warn, "[Resolver] InitFixedData() failed.");
+        return false;
+    }
+
+    bool Success = false;
+    Safe::TryExcept(
+        [&]() { Success = Runtime->ResolveDynamicData(); },
+        [&](uint32_t ExceptionCode) {
+            LOG(Warn, "[Resolver] ResolveDynamicData() caught an exception, code: {:#x}",
+                ExceptionCode);
+        });
+
+    for (const auto &Timing : Runtime->GetTimings()) {
+        Result["timing_us"][Timing.Name] = duration_cast<microseconds>(Timing.Elapsed).count();
+    }
+
+    if (!Success) {
+        return false;
+    }
+
+    Result["data"] = DumpData(*Runtime);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    auto PrintUsage = [&]() {
+        std::fprintf(
+            stderr,
+            "Usage: %s [--bench [--runs <N>]] <Telegram.exe>...\n"
+            "       %s --diff <old.jsonl> <new.jsonl>\n",
+            argv[0], argv[0]);
+        return 2;
+    };
+
+    spdlog::set_default_logger(spdlog::stderr_color_mt("Resolver"));
+
+    if (argc >= 2 && std::string_view{argv[1]} == "--diff") {
+        if (argc != 4) {
+            return PrintUsage();
+        }
+        return DiffBenchRuns(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    uint32_t BenchRuns = 0;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; ++i) {
+        std::string_view Option{argv[i]};
+        if (Option == "--bench") {
+            BenchRuns = std::max(BenchRuns, 5u);
+        }
+        else if (Option == "--runs" && i + 1 < argc) {
+            BenchRuns = std::max((uint32_t)std::strtoul(argv[++i], nullptr, 10), 1u);
+        }
+        else {
+            return PrintUsage();
+        }
+    }
+
+    if (i == argc) {
+        return PrintUsage();
+    }
+
+    int ExitCode = 0;
+
+    for (; i < argc; ++i) {
+        LOG(Info, "[Resolver] Resolving \"{}\"", argv[i]);
+
+        json Result;
+        bool Success = Resolve(argv[i], BenchRuns, Result);
+        Result["success"] = Success;
+        if (!Success) {
+            ExitCode = 1;
+        }
+
+        std::printf("%s\n", Result.dump().c_str());
+        std::fflush(stdout);
+    }
+
+    return ExitCode;
+}
@@ -0,0 +1,76 @@
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <unordered_set>
+
+#include "Harness.h"
+#include "AddressFilter.h"
+
+// Every thread frees blocks none of which is blocked, like Telegram does almost all the time, and
+// checks each of them the way `IAntiRevoke::OnFree()` does. Compared against the mutex and the
+// `unordered_set` it used to look every block up in.
+//
+constexpr uint32_t FreesPerThread = 2000000;
+constexpr uintptr_t BlockedCount = 64;
+
+static void *MakeAddress(uintptr_t Index)
+{
+    return (void *)(0x10000000 + Index * 0x40);
+}
+
+template <class CheckT>
+static double MeasureFrees(uint32_t ThreadCount, CheckT &&Check)
+{
+    return Harness::MeasureBest(3, [&]() {
+        std::vector<std::thread> Threads;
+        for (uint32_t i = 0; i < ThreadCount; ++i) {
+            Threads.emplace_back([&, i]() {
+                uint32_t Hits = 0;
+                for (uintptr_t j = 0; j < FreesPerThread; ++j) {
+                    Hits += Check(MakeAddress(0x100000 + i * FreesPerThread + j)) ? 1 : 0;
+                }
+                Harness::KeepAlive(Hits);
+            });
+        }
+        for (std::thread &Thread : Threads) {
+            Thread.join();
+        }
+    });
+}
+
+BENCHMARK(AddressFilter, OnFreeScaling)
+{
+    AddressFilter Filter;
+    std::mutex Mutex;
+    std::unordered_set<void *> Blocked;
+
+    for (uintptr_t i = 0; i < BlockedCount; ++i) {
+        Filter.Add(MakeAddress(i));
+        Blocked.insert(MakeAddress(i));
+    }
+
+    std::printf("  %8s %16s %16s\n", "threads", "mutex (Mop/s)", "filter (Mop/s)");
+
+    const uint32_t MaxThreads = std::max(std::thread::hardware_concurrency(), 1u) * 2;
+    for (uint32_t ThreadCount = 1; ThreadCount <= MaxThreads; ThreadCount *= 2) {
+        const double Operations = (double)ThreadCount * FreesPerThread / 1e6;
+
+        const double LockedTime = MeasureFrees(ThreadCount, [&](void *Address) {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            return Blocked.erase(Address) != 0;
+        });
+
+        const double FilterTime = MeasureFrees(ThreadCount, [&](void *Address) {
+            if (!Filter.MayContain(Address)) {
+                return false;
+            }
+            std::lock_guard<std::mutex> Lock(Mutex);
+            return Blocked.erase(Address) != 0;
+        });
+
+        std::printf(
+            "  %8u %16.1f %16.1f\n", ThreadCount, Operations / LockedTime,
+            Operations / FilterTime);
+    }
+}
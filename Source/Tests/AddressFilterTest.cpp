@@ -0,0 +1,107 @@
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Harness.h"
+#include "AddressFilter.h"
+
+static void *MakeAddress(uintptr_t Index)
+{
+    return (void *)(0x10000000 + Index * 0x40);
+}
+
+TEST_CASE(AddressFilter, AddRemove)
+{
+    AddressFilter Filter;
+
+    for (uintptr_t i = 0; i < 64; ++i) {
+        Filter.Add(MakeAddress(i));
+    }
+    for (uintptr_t i = 0; i < 64; ++i) {
+        CHECK(Filter.MayContain(MakeAddress(i)));
+    }
+
+    for (uintptr_t i = 0; i < 64; ++i) {
+        Filter.Remove(MakeAddress(i));
+    }
+    for (uintptr_t i = 0; i < 64; ++i) {
+        CHECK(!Filter.MayContain(MakeAddress(i)));
+    }
+}
+
+TEST_CASE(AddressFilter, DuplicateAdd)
+{
+    AddressFilter Filter;
+
+    Filter.Add(MakeAddress(1));
+    Filter.Add(MakeAddress(1));
+    Filter.Remove(MakeAddress(1));
+    CHECK(Filter.MayContain(MakeAddress(1)));
+
+    Filter.Remove(MakeAddress(1));
+    CHECK(!Filter.MayContain(MakeAddress(1)));
+}
+
+TEST_CASE(AddressFilter, FalsePositiveRate)
+{
+    AddressFilter Filter;
+
+    // About as many blocks as are ever blocked at once
+    //
+    for (uintptr_t i = 0; i < 100; ++i) {
+        Filter.Add(MakeAddress(i * 7919));
+    }
+
+    uint32_t FalsePositives = 0;
+    for (uintptr_t i = 0; i < 100000; ++i) {
+        FalsePositives += Filter.MayContain(MakeAddress(0x1000000 + i)) ? 1 : 0;
+    }
+    CHECK(FalsePositives < 100);
+}
+
+// The owner adds and removes under its lock while every other thread probes. Addresses that stay
+// added must never be reported missing.
+//
+TEST_CASE(AddressFilter, ConcurrentProbes)
+{
+    constexpr uintptr_t PinnedCount = 32;
+    const uint32_t ThreadCount = std::max(std::thread::hardware_concurrency(), 4u);
+
+    AddressFilter Filter;
+    std::mutex Mutex;
+    std::atomic<bool> IsStopped = false;
+    std::atomic<uint32_t> Misses = 0;
+
+    for (uintptr_t i = 0; i < PinnedCount; ++i) {
+        Filter.Add(MakeAddress(i));
+    }
+
+    std::vector<std::thread> Threads;
+    for (uint32_t i = 0; i < ThreadCount; ++i) {
+        Threads.emplace_back([&, i]() {
+            for (uintptr_t Round = 0; !IsStopped.load(std::memory_order_relaxed); ++Round) {
+                if (!Filter.MayContain(MakeAddress((Round + i) % PinnedCount))) {
+                    Misses.fetch_add(1, std::memory_order_relaxed);
+                }
+                Filter.MayContain(MakeAddress(0x100000 + Round));
+            }
+        });
+    }
+
+    for (uintptr_t Round = 0; Round < 200000; ++Round) {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Filter.Add(MakeAddress(0x200000 + Round));
+        Filter.Remove(MakeAddress(0x200000 + Round));
+    }
+
+    IsStopped = true;
+    for (std::thread &Thread : Threads) {
+        Thread.join();
+    }
+
+    CHECK(Misses == 0);
+    for (uintptr_t i = 0; i < PinnedCount; ++i) {
+        CHECK(Filter.MayContain(MakeAddress(i)));
+    }
+}
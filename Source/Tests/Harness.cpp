@@ -0,0 +1,66 @@
+#include "Harness.h"
+
+#include <exception>
+#include <string_view>
+
+namespace Harness {
+
+static uint32_t FailureCount = 0;
+
+std::vector<CaseT> &GetCases()
+{
+    static std::vector<CaseT> Cases;
+    return Cases;
+}
+
+void Fail(const char *File, int Line, const char *Expression)
+{
+    std::printf("  %s(%d): CHECK(%s) failed.\n", File, Line, Expression);
+    ++FailureCount;
+}
+
+} // namespace Harness
+
+int main(int argc, char *argv[])
+{
+    const std::string_view Filter = argc > 1 ? argv[1] : "";
+
+    auto Cases = Harness::GetCases();
+    std::sort(Cases.begin(), Cases.end(), [](const auto &Left, const auto &Right) {
+        return std::string_view{Left.Name} < std::string_view{Right.Name};
+    });
+
+    uint32_t RunCount = 0, FailedCount = 0;
+    for (const auto &[Name, Function] : Cases) {
+        if (std::string_view{Name}.substr(0, Filter.size()) != Filter) {
+            continue;
+        }
+
+        std::printf("[ RUN  ] %s\n", Name);
+        std::fflush(stdout);
+
+        const auto FailuresBefore = Harness::FailureCount;
+        try {
+            Function();
+        }
+        catch (const std::exception &Exception) {
+            std::printf("  Uncaught exception. What: %s\n", Exception.what());
+            ++Harness::FailureCount;
+        }
+
+        const bool IsPassed = Harness::FailureCount == FailuresBefore;
+        std::printf("[ %s ] %s\n", IsPassed ? " OK " : "FAIL", Name);
+        std::fflush(stdout);
+
+        ++RunCount;
+        FailedCount += IsPassed ? 0 : 1;
+    }
+
+    if (RunCount == 0) {
+        std::printf("No case matches \"%.*s\".\n", (int)Filter.size(), Filter.data());
+        return 1;
+    }
+
+    std::printf("%u of %u cases passed.\n", RunCount - FailedCount, RunCount);
+    return FailedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+// A minimal test runner shared by `Tests` and `Benchmarks`, so the portable parts of the plugin
+// can be checked with any compiler, without the Windows-only targets or a test framework.
+//
+// Cases are named "<Suite>.<Name>". Both executables run the cases whose name starts with their
+// first argument, or all of them. CTest registers each suite of `Tests` separately.
+//
+namespace Harness {
+
+using FnCaseT = void (*)();
+
+struct CaseT
+{
+    const char *Name;
+    FnCaseT Function;
+};
+
+std::vector<CaseT> &GetCases();
+
+struct Registrar
+{
+    Registrar(const char *Name, FnCaseT Function)
+    {
+        GetCases().push_back({Name, Function});
+    }
+};
+
+// Records a failure of the running case, which still continues.
+//
+void Fail(const char *File, int Line, const char *Expression);
+
+// Returns the fastest of `Runs` calls in seconds
+//
+template <class CallbackT>
+double MeasureBest(uint32_t Runs, CallbackT &&Callback)
+{
+    using Clock = std::chrono::steady_clock;
+
+    double Best = 0;
+    for (uint32_t i = 0; i < std::max(Runs, 1u); ++i) {
+        auto Begin = Clock::now();
+        Callback();
+        double Elapsed = std::chrono::duration<double>(Clock::now() - Begin).count();
+
+        if (i == 0 || Elapsed < Best) {
+            Best = Elapsed;
+        }
+    }
+    return Best;
+}
+
+// Keeps the compiler from dropping a computation whose result is otherwise unused.
+//
+template <class T>
+void KeepAlive(const T &Value)
+{
+    static volatile const void *Sink;
+    Sink = &Value;
+}
+
+} // namespace Harness
+
+#define TAR_CASE_NAME(Suite, Name) Suite##_##Name
+
+#define TAR_CASE(Suite, Name)                                                                      \
+    static void TAR_CASE_NAME(Suite, Name)();                                                      \
+    static Harness::Registrar TAR_CASE_NAME(Suite, Name##Registrar){                               \
+        #Suite "." #Name, &TAR_CASE_NAME(Suite, Name)};                                            \
+    static void TAR_CASE_NAME(Suite, Name)()
+
+#define TEST_CASE(Suite, Name) TAR_CASE(Suite, Name)
+#define BENCHMARK(Suite, Name) TAR_CASE(Suite, Name)
+
+#define CHECK(Expression)                                                                          \
+    ((Expression) ? (void)0 : Harness::Fail(__FILE__, __LINE__, #Expression))
@@ -0,0 +1,52 @@
+#include <vector>
+
+#include "Harness.h"
+#include "SyntheticMessage.h"
+
+// What the revoke hook pays per destroyed message to find the fields of the message: the real
+// `HistoryMessage::IsMessage()`, `GetTimeText()` and `GetTimeWidth()` over a published layout,
+// each of which loads the layout pointer, against the same reads at offsets known up front.
+//
+constexpr uint32_t MessageCount = 4096;
+
+BENCHMARK(Layout, PerMessageAccess)
+{
+    const uint32_t Version = Layouts::IsServiceMinVersion;
+    const auto Layout =
+        SyntheticMessage::MakeLayout(*SyntheticMessage::FindEntry(Version), Version);
+    ResolvedLayout::Publish(&Layout);
+
+    std::vector<SyntheticObject> Messages(MessageCount);
+    for (auto &Message : Messages) {
+        SyntheticMessage::Init(Message, false);
+    }
+
+    // Each destroyed message checks `IsMessage()`, then reads the time text and width
+    //
+    uint64_t Sum = 0;
+    const double AccessorTime = Harness::MeasureBest(20, [&]() {
+        for (auto &Message : Messages) {
+            auto pMessage = Message.As<HistoryMessage>();
+            Sum += pMessage->IsMessage() + (uintptr_t)pMessage->GetTimeText()->GetData() +
+                   pMessage->GetTimeWidth();
+        }
+    });
+
+    const Layouts::OffsetT Offset = Layout.Offset;
+    const auto FnIsMessage = Layout.FnIsMessage;
+    const uint32_t Index = Layout.Index.IsService;
+    const double FixedTime = Harness::MeasureBest(20, [&]() {
+        for (auto &Message : Messages) {
+            Sum += FnIsMessage(Message.As<HistoryMessage>(), Index) +
+                   (uintptr_t)Message.Read<QtArrayData *>(Offset.TimeText) +
+                   Message.Read<int32_t>(Offset.TimeWidth);
+        }
+    });
+    Harness::KeepAlive(Sum);
+
+    ResolvedLayout::Publish(nullptr);
+
+    std::printf("  %-24s %12s\n", "", "ns/message");
+    std::printf("  %-24s %12.1f\n", "published layout", AccessorTime * 1e9 / MessageCount);
+    std::printf("  %-24s %12.1f\n", "fixed offsets", FixedTime * 1e9 / MessageCount);
+}
@@ -0,0 +1,161 @@
+#include <span>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+#include "Harness.h"
+#include "Layouts.h"
+
+// A field as laid out in a Telegram object, `Size` bytes at the offset the layout gives
+//
+struct FieldT
+{
+    const char *Name;
+    uint32_t Offset;
+    uint32_t Size;
+};
+
+// The fields of each class the accessors of `Telegram.cpp` read, with the size of their type on
+// the platform. `QString` holds a single pointer.
+//
+static std::vector<std::vector<FieldT>> GetObjects(const Layouts::OffsetT &Offset, uint32_t Pointer)
+{
+    return {
+        // HistoryMessage
+        {{"time_text", Offset.TimeText, Pointer},
+         {"time_width", Offset.TimeWidth, 4},
+         {"main_view", Offset.MainView, Pointer}},
+        // HistoryMessageEdited, HistoryMessageSigned, HistoryMessageReply
+        {{"edited_time_text", Offset.EditedTimeText, Pointer}},
+        {{"signed_time_text", Offset.SignedTimeText, Pointer}},
+        {{"max_reply_width", Offset.MaxReplyWidth, 4}},
+        // HistoryView::Element
+        {{"element_media", Offset.ElementMedia, Pointer}},
+        // Lang::Instance
+        {{"lang_id", Offset.LangId, Pointer},
+         {"lang_plural_id", Offset.LangPluralId, Pointer},
+         {"lang_name", Offset.LangName, Pointer},
+         {"lang_native_name", Offset.LangNativeName, Pointer}},
+    };
+}
+
+// For every generation of a table, the versions it covers must select it, and an object laid out
+// by it must read back what was written to each field.
+//
+static void CheckTable(std::span<const Layouts::EntryT> Table, uint32_t Pointer)
+{
+    CHECK(!Table.empty());
+
+    for (size_t i = 0; i < Table.size(); ++i) {
+        const auto &Entry = Table[i];
+        auto Find = [&](uint32_t Version) {
+            return Layouts::FindEntry(Table.data(), Table.data() + Table.size(), Version);
+        };
+
+        // Selection by version
+        //
+        CHECK(Find(Entry.MinVersion) == &Entry);
+        if (i + 1 < Table.size()) {
+            CHECK(Table[i + 1].MinVersion > Entry.MinVersion);
+            CHECK(Find(Table[i + 1].MinVersion - 1) == &Entry);
+        }
+        else {
+            CHECK(Find(UINT32_MAX) == &Entry);
+        }
+        if (i == 0 && Entry.MinVersion != 0) {
+            CHECK(Find(Entry.MinVersion - 1) == nullptr);
+        }
+
+        // A synthetic object of each class, every field written then read back through its
+        // offset. Overlapping or misaligned fields would clobber each other.
+        //
+        for (const auto &Fields : GetObjects(Entry.Offset, Pointer)) {
+            uint32_t ObjectSize = 0;
+            for (const auto &Field : Fields) {
+                CHECK(Field.Offset % Field.Size == 0);
+                ObjectSize = std::max(ObjectSize, Field.Offset + Field.Size);
+            }
+
+            std::vector<uint8_t> Object(ObjectSize, 0xCD);
+            for (size_t j = 0; j < Fields.size(); ++j) {
+                std::memset(Object.data() + Fields[j].Offset, (int)(j + 1), Fields[j].Size);
+            }
+            for (size_t j = 0; j < Fields.size(); ++j) {
+                const auto Begin = Object.begin() + Fields[j].Offset;
+                const bool IsIntact = std::all_of(
+                    Begin, Begin + Fields[j].Size, [&](uint8_t Byte) { return Byte == j + 1; });
+                if (!IsIntact) {
+                    std::printf(
+                        "  Version %u: \"%s\" overlaps another field.\n", Entry.MinVersion,
+                        Fields[j].Name);
+                }
+                CHECK(IsIntact);
+            }
+        }
+    }
+}
+
+TEST_CASE(Layouts, X86Generations)
+{
+    CheckTable(Layouts::EmbeddedX86, 4);
+
+    // Versions each x86 generation is known from
+    //
+    auto Find = [](uint32_t Version) {
+        return Layouts::FindEntry(
+            std::begin(Layouts::EmbeddedX86), std::end(Layouts::EmbeddedX86), Version);
+    };
+    CHECK(Find(2003000) == nullptr);
+    CHECK(Find(2005009)->MinVersion == 2004001);
+    CHECK(Find(2007002)->MinVersion == 2006000);
+    CHECK(Find(3001006)->MinVersion == 2009000);
+    CHECK(Find(3007000)->MinVersion == 3001007);
+    CHECK(Find(3007000)->Offset.MainView == 0x64);
+}
+
+TEST_CASE(Layouts, X64Generations)
+{
+    CheckTable(Layouts::EmbeddedX64, 8);
+
+    auto Find = [](uint32_t Version) {
+        return Layouts::FindEntry(
+            std::begin(Layouts::EmbeddedX64), std::end(Layouts::EmbeddedX64), Version);
+    };
+    CHECK(Find(3001007)->Offset.MaxReplyWidth == 0xA4);
+    CHECK(Find(3001008)->Offset.MaxReplyWidth == 0xAC);
+}
+
+TEST_CASE(Layouts, Fields)
+{
+    // Every field of `OffsetT` has a unique name in the override file
+    //
+    Layouts::OffsetT Offset{};
+    const auto Fields = Layouts::GetFields(Offset);
+    CHECK(Fields.size() * sizeof(uint32_t) == sizeof(Offset));
+
+    for (size_t i = 0; i < Fields.size(); ++i) {
+        *Fields[i].second = (uint32_t)i;
+        for (size_t j = 0; j < i; ++j) {
+            CHECK(std::string{Fields[i].first} != Fields[j].first);
+            CHECK(Fields[i].second != Fields[j].second);
+        }
+    }
+    CHECK(Offset.TimeText == 0 && Offset.LangNativeName == Fields.size() - 1);
+}
+
+TEST_CASE(Layouts, FindEntry)
+{
+    constexpr Layouts::EntryT Table[] = {{100, {}}, {200, {}}, {300, {}}};
+    auto Find = [&](uint32_t Version) {
+        auto pEntry = Layouts::FindEntry(std::begin(Table), std::end(Table), Version);
+        return pEntry != nullptr ? pEntry->MinVersion : 0;
+    };
+
+    CHECK(Find(0) == 0);
+    CHECK(Find(99) == 0);
+    CHECK(Find(100) == 100);
+    CHECK(Find(199) == 100);
+    CHECK(Find(200) == 200);
+    CHECK(Find(UINT32_MAX) == 300);
+    CHECK(Layouts::FindEntry(std::begin(Table), std::begin(Table), 200) == nullptr);
+}
@@ -0,0 +1,219 @@
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <condition_variable>
+
+#include <spdlog/pattern_formatter.h>
+#include <spdlog/details/file_helper.h>
+
+#include "Harness.h"
+#include "MessageRing.h"
+
+// The latency of `LOG(Debug, ...)` on the calling threads, the way `CCustomFileSink` handles it
+// now and the way it did before. Every thread logs a message with two arguments, like the revoke
+// hook does for each deleted message.
+//
+// Synchronously, the caller formats, writes and flushes the message under the mutex of the sink,
+// as with `spdlog::flush_on(trace)`. Asynchronously, it encodes the arguments into the ring, and a
+// writer formats and writes them in batches with one flush each, see `Logger.cpp`. The threads log
+// far more than the ring holds, and what doesn't fit is dropped and counted rather than waited for.
+//
+constexpr uint32_t MessagesPerThread = 20000;
+
+static const spdlog::source_loc Source{"LogBench.cpp", 1, "Log"};
+constexpr char Format[] = "Caught a deleted message. Id: {}, Thread: {}";
+
+using Clock = std::chrono::steady_clock;
+
+class SyncSink
+{
+public:
+    explicit SyncSink(const std::filesystem::path &Filename)
+    {
+        _FileHelper.open(Filename.string(), true);
+    }
+
+    void Log(uint32_t Id, uint32_t Thread)
+    {
+        const auto Payload = fmt::format(Format, Id, Thread);
+        spdlog::details::log_msg Message{
+            Source, BinaryLog::LoggerName, spdlog::level::debug, Payload};
+
+        std::lock_guard<std::mutex> Lock{_Mutex};
+        spdlog::memory_buf_t Text;
+        _Formatter.format(Message, Text);
+        _FileHelper.write(Text);
+        _FileHelper.flush();
+    }
+
+    uint64_t GetDroppedCount() const
+    {
+        return 0;
+    }
+
+private:
+    std::mutex _Mutex;
+    spdlog::pattern_formatter _Formatter;
+    spdlog::details::file_helper _FileHelper;
+};
+
+class AsyncSink
+{
+public:
+    explicit AsyncSink(const std::filesystem::path &Filename)
+    {
+        _FileHelper.open(Filename.string(), true);
+        _Writer = std::thread{[this]() { RunWriter(); }};
+    }
+
+    ~AsyncSink()
+    {
+        _IsStopping = true;
+        _Wake.notify_one();
+        _Writer.join();
+    }
+
+    void Log(uint32_t Id, uint32_t Thread)
+    {
+        std::byte Args[BinaryLog::MaxArgsSize];
+        BinaryLog::ArgWriter Writer{Args, sizeof(Args)};
+        Writer.Write(Id);
+        Writer.Write(Thread);
+
+        const auto Position =
+            _Ring.Push(Source, spdlog::level::debug, Format, Args, Writer.GetSize());
+        if (!Position.has_value()) {
+            _DroppedCount.fetch_add(1, std::memory_order_relaxed);
+            _Wake.notify_one();
+            return;
+        }
+
+        if (Position.value() % WakeBatch == WakeBatch - 1) {
+            _Wake.notify_one();
+        }
+    }
+
+    uint64_t GetDroppedCount() const
+    {
+        return _DroppedCount;
+    }
+
+private:
+    static constexpr auto FlushInterval = std::chrono::milliseconds{200};
+    static constexpr size_t WakeBatch = 64;
+
+    CMessageRing _Ring;
+    std::atomic<uint64_t> _DroppedCount = 0;
+    spdlog::pattern_formatter _Formatter;
+    spdlog::details::file_helper _FileHelper;
+    std::mutex _WakeMutex;
+    std::condition_variable _Wake;
+    std::atomic<bool> _IsStopping = false;
+    std::thread _Writer;
+
+    void RunWriter()
+    {
+        std::unique_lock<std::mutex> WakeLock{_WakeMutex};
+
+        while (!_IsStopping) {
+            _Wake.wait_for(WakeLock, FlushInterval);
+            if (Drain() != 0) {
+                _FileHelper.flush();
+            }
+        }
+        Drain(true);
+        _FileHelper.flush();
+    }
+
+    size_t Drain(bool IsComplete = false)
+    {
+        return _Ring.Drain(
+            [&](spdlog::details::log_msg Message, const char *Format) {
+                const auto Payload = BinaryLog::FormatArgs(
+                    Format, (const std::byte *)Message.payload.data(), Message.payload.size());
+                Message.payload = Payload.value_or("");
+
+                spdlog::memory_buf_t Text;
+                _Formatter.format(Message, Text);
+                _FileHelper.write(Text);
+            },
+            IsComplete);
+    }
+};
+
+struct ResultT
+{
+    std::vector<uint32_t> Latencies; // Of all calls in nanoseconds, sorted
+    uint64_t DroppedCount;
+};
+
+template <class SinkT>
+static ResultT MeasureLatencies(uint32_t ThreadCount)
+{
+    const auto Filename = std::filesystem::temp_directory_path() / "TAR-LogBench.txt";
+    std::vector<std::vector<uint32_t>> Latencies(ThreadCount);
+    ResultT Result;
+
+    {
+        SinkT Sink{Filename};
+
+        std::vector<std::thread> Threads;
+        for (uint32_t i = 0; i < ThreadCount; ++i) {
+            Threads.emplace_back([&, i]() {
+                Latencies[i].reserve(MessagesPerThread);
+                for (uint32_t j = 0; j < MessagesPerThread; ++j) {
+                    const auto Begin = Clock::now();
+                    Sink.Log(j, i);
+                    Latencies[i].push_back(
+                        (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            Clock::now() - Begin)
+                            .count());
+                }
+            });
+        }
+        for (std::thread &Thread : Threads) {
+            Thread.join();
+        }
+        Result.DroppedCount = Sink.GetDroppedCount();
+    }
+
+    std::error_code ErrorCode;
+    std::filesystem::remove(Filename, ErrorCode);
+
+    for (const auto &ThreadLatencies : Latencies) {
+        Result.Latencies.insert(
+            Result.Latencies.end(), ThreadLatencies.begin(), ThreadLatencies.end());
+    }
+    std::sort(Result.Latencies.begin(), Result.Latencies.end());
+    return Result;
+}
+
+static void PrintResult(const char *Name, uint32_t ThreadCount, const ResultT &Result)
+{
+    const auto &Latencies = Result.Latencies;
+    auto Percentile = [&](double Fraction) {
+        return Latencies[std::min((size_t)(Latencies.size() * Fraction), Latencies.size() - 1)];
+    };
+
+    std::printf(
+        "  %8u %6s %10u %10u %10u %10u %10llu\n", ThreadCount, Name, Percentile(0.5),
+        Percentile(0.99), Percentile(0.999), Latencies.back(),
+        (unsigned long long)Result.DroppedCount);
+}
+
+BENCHMARK(Log, CallerLatency)
+{
+    std::printf(
+        "  %8s %6s %10s %10s %10s %10s %10s\n", "threads", "sink", "p50 (ns)", "p99 (ns)",
+        "p99.9 (ns)", "max (ns)", "dropped");
+
+    const uint32_t MaxThreads = std::max(std::thread::hardware_concurrency(), 1u) * 2;
+    for (uint32_t ThreadCount = 1; ThreadCount <= MaxThreads; ThreadCount *= 2) {
+        PrintResult("sync", ThreadCount, MeasureLatencies<SyncSink>(ThreadCount));
+        PrintResult("async", ThreadCount, MeasureLatencies<AsyncSink>(ThreadCount));
+    }
+}
@@ -0,0 +1,116 @@
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Harness.h"
+#include "MessageRing.h"
+
+static const spdlog::source_loc Source{"MessageRingTest.cpp", 1, "Test"};
+static const char Format[] = "{} {}";
+
+static bool PushEncoded(CMessageRing &Ring, uint32_t Producer, uint32_t Index)
+{
+    std::byte Args[BinaryLog::MaxArgsSize];
+    BinaryLog::ArgWriter Writer{Args, sizeof(Args)};
+    Writer.Write(Producer);
+    Writer.Write(Index);
+    return Ring.Push(Source, spdlog::level::debug, Format, Args, Writer.GetSize()).has_value();
+}
+
+TEST_CASE(MessageRing, Full)
+{
+    CMessageRing Ring;
+
+    for (size_t i = 0; i < CMessageRing::Capacity; ++i) {
+        CHECK(PushEncoded(Ring, 0, (uint32_t)i));
+    }
+    CHECK(!PushEncoded(Ring, 0, 0));
+
+    size_t Count = Ring.Drain([](const spdlog::details::log_msg &, const char *) {});
+    CHECK(Count == CMessageRing::Capacity);
+    CHECK(PushEncoded(Ring, 0, 0));
+}
+
+TEST_CASE(MessageRing, Payload)
+{
+    CMessageRing Ring;
+
+    spdlog::details::log_msg Message{
+        Source, BinaryLog::LoggerName, spdlog::level::info, "Formatted on the caller"};
+    CHECK(Ring.Push(Message).has_value());
+    CHECK(PushEncoded(Ring, 7, 42));
+
+    std::vector<std::string> Texts;
+    Ring.Drain([&](const spdlog::details::log_msg &Message, const char *Format) {
+        std::string_view Payload{Message.payload.data(), Message.payload.size()};
+        if (Format == nullptr) {
+            Texts.emplace_back(Payload);
+        }
+        else {
+            Texts.push_back(BinaryLog::FormatArgs(Format, (const std::byte *)Payload.data(),
+                                                  Payload.size())
+                                .value_or("Malformed"));
+        }
+        CHECK(Message.source.line == Source.line);
+    });
+
+    CHECK(Texts == std::vector<std::string>({"Formatted on the caller", "7 42"}));
+}
+
+// Producers retry on a full ring until their message is in. Each message must arrive exactly
+// once, and those of each producer in order.
+//
+TEST_CASE(MessageRing, ProducersInOrder)
+{
+    constexpr uint32_t ProducerCount = 8;
+    constexpr uint32_t MessagesPerProducer = 20000;
+
+    CMessageRing Ring;
+    std::vector<uint32_t> NextIndex(ProducerCount, 0);
+    uint32_t Errors = 0;
+
+    auto Consume = [&](const spdlog::details::log_msg &Message, const char *Format) {
+        const auto Text = BinaryLog::FormatArgs(
+            Format, (const std::byte *)Message.payload.data(), Message.payload.size());
+
+        uint32_t Producer, Index;
+        if (!Text.has_value() || std::sscanf(Text->c_str(), "%u %u", &Producer, &Index) != 2 ||
+            Producer >= ProducerCount || Index != NextIndex[Producer]++)
+        {
+            ++Errors;
+        }
+    };
+
+    std::atomic<bool> IsDone = false;
+    std::thread Consumer{[&]() {
+        while (!IsDone.load()) {
+            if (Ring.Drain(Consume) == 0) {
+                std::this_thread::yield();
+            }
+        }
+        Ring.Drain(Consume, true);
+    }};
+
+    std::vector<std::thread> Producers;
+    for (uint32_t i = 0; i < ProducerCount; ++i) {
+        Producers.emplace_back([&, i]() {
+            for (uint32_t j = 0; j < MessagesPerProducer; ++j) {
+                while (!PushEncoded(Ring, i, j)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread &Producer : Producers) {
+        Producer.join();
+    }
+    IsDone = true;
+    Consumer.join();
+
+    CHECK(Errors == 0);
+    for (uint32_t i = 0; i < ProducerCount; ++i) {
+        CHECK(NextIndex[i] == MessagesPerProducer);
+    }
+}
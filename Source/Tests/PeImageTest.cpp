@@ -0,0 +1,167 @@
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+#include "Harness.h"
+#include "SyntheticPe.h"
+
+static std::vector<SyntheticSectionT> MakeSections()
+{
+    std::vector<std::byte> Text(0x1800, std::byte{0xCC}), Data(0x200, std::byte{0x11}),
+        ReadOnly(0x300, std::byte{0x22});
+
+    // ".data" has more virtual than raw size, the rest is zeroed at load time
+    //
+    return {
+        {".text", 0x1000, 0x1800, SyntheticPe::SectionCode, Text},
+        {".rdata", 0x3000, 0x300, SyntheticPe::SectionRData, ReadOnly},
+        {".data", 0x4000, 0x2000, SyntheticPe::SectionData, Data},
+    };
+}
+
+static void CheckImage(const PeImage &Image, const std::vector<std::byte> &Buffer, bool Is64Bit)
+{
+    CHECK(Image.Is64Bit() == Is64Bit);
+    CHECK(Image.GetImageBase() == (Is64Bit ? 0x140000000 : 0x400000));
+    CHECK(Image.GetSizeOfImage() == 0x7000);
+    CHECK(Image.GetSizeOfHeaders() == SyntheticPe::SizeOfHeaders);
+    CHECK(Image.GetTimeDateStamp() == 0x60000000);
+
+    const auto &Sections = Image.GetSections();
+    CHECK(Sections.size() == 4);
+    CHECK(Image.FindSection(".reloc") != nullptr);
+    CHECK(Image.FindSection(".bss") == nullptr);
+
+    const auto pText = Image.FindSection(".text");
+    CHECK(pText != nullptr);
+    if (pText == nullptr) {
+        return;
+    }
+    CHECK(pText->VirtualAddress == 0x1000 && pText->VirtualSize == 0x1800);
+    CHECK((pText->Characteristics & PeImage::SectionExecute) != 0);
+    CHECK(Image.GetSectionSize(*pText) == 0x1800);
+    CHECK(*Image.GetSectionBegin(*pText) == std::byte{0xCC});
+
+    CHECK(Image.FindSectionByRva(0x1000) == pText);
+    CHECK(Image.FindSectionByRva(0x27FF) == pText);
+    CHECK(Image.FindSectionByRva(0x2800) == nullptr);
+    CHECK(Image.FindSectionByRva(0x4100) == Image.FindSection(".data"));
+
+    CHECK(Image.GetPointer(0x1010) == Image.GetSectionBegin(*pText) + 0x10);
+    CHECK(Image.GetPointer(0x3000) != nullptr && *Image.GetPointer(0x3000) == std::byte{0x22});
+    CHECK(Image.GetPointer(0x80) == Buffer.data() + 0x80);
+    CHECK(Image.GetPointer(0x10000) == nullptr);
+
+    CHECK(Image.IsInSections(Image.GetPointer(0x3010), {".data", ".rdata"}));
+    CHECK(!Image.IsInSections(Image.GetPointer(0x1010), {".data", ".rdata"}));
+    CHECK(!Image.IsInSections(Buffer.data(), {".text"}));
+
+    const auto Relocations = Image.GetRelocations();
+    CHECK(Relocations.has_value());
+    CHECK(Relocations.has_value() &&
+          *Relocations == std::vector<uint32_t>({0x1008, 0x1010, 0x4000}));
+}
+
+TEST_CASE(PeImage, FileLayout)
+{
+    for (bool Is64Bit : {false, true}) {
+        SyntheticPe::OptionsT Options;
+        Options.Is64Bit = Is64Bit;
+        Options.ImageBase = Is64Bit ? 0x140000000 : 0x400000;
+        Options.Relocations = {0x1008, 0x1010, 0x4000};
+
+        const auto Buffer = SyntheticPe::Build(Options, MakeSections(), PeImage::Layout::File);
+        auto Image = PeImage::Parse(Buffer.data(), Buffer.size(), PeImage::Layout::File);
+        CHECK(Image.has_value());
+        if (!Image.has_value()) {
+            continue;
+        }
+        CheckImage(Image.value(), Buffer, Is64Bit);
+
+        // Only the initialized part of a section is in a file, and nothing past it is readable
+        //
+        const auto pData = Image->FindSection(".data");
+        CHECK(Image->GetSectionSize(*pData) == 0x200);
+        CHECK(Image->GetPointer(0x4200) == nullptr);
+        CHECK(Image->GetSectionBegin(*pData) == Buffer.data() + pData->PointerToRawData);
+    }
+}
+
+TEST_CASE(PeImage, MappedLayout)
+{
+    for (bool Is64Bit : {false, true}) {
+        SyntheticPe::OptionsT Options;
+        Options.Is64Bit = Is64Bit;
+        Options.ImageBase = Is64Bit ? 0x140000000 : 0x400000;
+        Options.Relocations = {0x1008, 0x1010, 0x4000};
+
+        const auto Buffer = SyntheticPe::Build(Options, MakeSections(), PeImage::Layout::Mapped);
+        auto Image = PeImage::Parse(Buffer.data(), Buffer.size(), PeImage::Layout::Mapped);
+        CHECK(Image.has_value());
+        if (!Image.has_value()) {
+            continue;
+        }
+        CheckImage(Image.value(), Buffer, Is64Bit);
+
+        const auto pData = Image->FindSection(".data");
+        CHECK(Image->GetSectionSize(*pData) == 0x2000);
+        CHECK(Image->GetPointer(0x4200) == Buffer.data() + 0x4200);
+        CHECK(Image->GetSectionBegin(*pData) == Buffer.data() + 0x4000);
+    }
+}
+
+TEST_CASE(PeImage, FileOnDisk)
+{
+    const auto Pe = SyntheticPe::Build({}, MakeSections(), PeImage::Layout::File);
+    const auto Path = std::filesystem::temp_directory_path() / "TAR-PeImageTest.exe";
+    {
+        std::ofstream Output{Path, std::ios::binary | std::ios::trunc};
+        Output.write((const char *)Pe.data(), Pe.size());
+    }
+
+    std::ifstream Input{Path, std::ios::binary};
+    std::vector<char> File{std::istreambuf_iterator<char>{Input}, {}};
+    Input.close();
+    std::filesystem::remove(Path);
+
+    auto Image = PeImage::Parse((const std::byte *)File.data(), File.size(), PeImage::Layout::File);
+    CHECK(Image.has_value());
+    CHECK(Image.has_value() && Image->GetSections().size() == 3);
+    CHECK(Image.has_value() && Image->GetRelocations()->empty());
+}
+
+TEST_CASE(PeImage, Malformed)
+{
+    const auto Pe = SyntheticPe::Build({}, MakeSections(), PeImage::Layout::File);
+    CHECK(PeImage::Parse(Pe.data(), Pe.size(), PeImage::Layout::File).has_value());
+
+    // Truncated anywhere in the headers
+    //
+    for (size_t Size : {0, 2, 0x3C, 0x80, 0x90, 0x100, 0x188, 0x1FF}) {
+        CHECK(!PeImage::Parse(Pe.data(), Size, PeImage::Layout::File).has_value());
+    }
+
+    auto Corrupt = [&](size_t Offset, std::byte Value) {
+        auto Copy = Pe;
+        Copy[Offset] = Value;
+        return PeImage::Parse(Copy.data(), Copy.size(), PeImage::Layout::File).has_value();
+    };
+    CHECK(!Corrupt(0, std::byte{'N'}));     // MZ
+    CHECK(!Corrupt(0x3F, std::byte{0x7F})); // e_lfanew out of the buffer
+    CHECK(!Corrupt(0x80, std::byte{'N'}));  // PE\0\0
+    CHECK(!Corrupt(0x98, std::byte{0x0C})); // Optional header magic
+
+    // A relocation block running past the directory
+    //
+    SyntheticPe::OptionsT Options;
+    Options.Relocations = {0x1008};
+    auto WithRelocations = SyntheticPe::Build(Options, MakeSections(), PeImage::Layout::Mapped);
+    auto Image =
+        PeImage::Parse(WithRelocations.data(), WithRelocations.size(), PeImage::Layout::Mapped);
+    CHECK(Image.has_value() && Image->GetRelocations().has_value());
+
+    const auto Directory = Image->GetDataDirectory(PeImage::DirectoryBaseReloc);
+    WithRelocations[Directory.VirtualAddress + 4] = std::byte{0xFF};
+    Image = PeImage::Parse(WithRelocations.data(), WithRelocations.size(), PeImage::Layout::Mapped);
+    CHECK(Image.has_value() && !Image->GetRelocations().has_value());
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstring>
+
+#include "Harness.h"
+#include "QtString.h"
+#include "ReadableMemory.h"
+
+using namespace std::chrono_literals;
+
+// The header and the text of a string as Qt lays them out in one block
+//
+struct TextDataT
+{
+    QtArrayData Header;
+    wchar_t Text[16];
+
+    TextDataT(const wchar_t *String, int32_t RefCount)
+    {
+        std::memset(this, 0, sizeof(*this));
+        Header.ref = RefCount;
+        Header.size = (int32_t)std::wcslen(String);
+        Header.alloc = Header.size + 1;
+        Header.offset = offsetof(TextDataT, Text);
+        std::wcscpy(Text, String);
+    }
+};
+
+// Holds a string the way Telegram's objects do, as a single pointer to its data
+//
+struct HolderT
+{
+    QtArrayData *pData;
+
+    QtString *GetString()
+    {
+        return (QtString *)&pData;
+    }
+};
+
+// Only `Data` is readable
+//
+static ReadableMemory MakeMemory(const TextDataT &Data)
+{
+    return ReadableMemory{
+        [&Data](uintptr_t Address) -> std::optional<ReadableMemory::RegionT> {
+            const auto Begin = (uintptr_t)&Data;
+            if (Address < Begin || Address >= Begin + sizeof(Data)) {
+                return std::nullopt;
+            }
+            return ReadableMemory::RegionT{Begin, Begin + sizeof(Data)};
+        },
+        1h};
+}
+
+TEST_CASE(QtString, SharedTime)
+{
+    // A marked text shared by two messages of the same minute, and held by the pool of marked
+    // texts as well
+    //
+    TextDataT Data{L"12:34", 3};
+    auto Memory = MakeMemory(Data);
+    HolderT First{&Data.Header}, Second{&Data.Header};
+
+    CHECK(First.GetString()->IsValidTime(Memory));
+    CHECK(Second.GetString()->IsValidTime(Memory));
+    CHECK(First.GetString()->GetView() == L"12:34");
+    CHECK(Second.GetString()->GetData() == First.GetString()->GetData());
+}
+
+TEST_CASE(QtString, RefCounts)
+{
+    auto IsValid = [](int32_t RefCount) {
+        TextDataT Data{L"12:34 AM", RefCount};
+        auto Memory = MakeMemory(Data);
+        HolderT Holder{&Data.Header};
+        return Holder.GetString()->IsValidTime(Memory);
+    };
+
+    CHECK(IsValid(1));
+    CHECK(IsValid(2));
+    CHECK(IsValid(-1)); // Static
+    CHECK(!IsValid(0)); // Unsharable
+    CHECK(!IsValid(-2));
+    CHECK(!IsValid(INT32_MIN));
+}
+
+TEST_CASE(QtString, NotTime)
+{
+    TextDataT Data{L"Yesterday, 12:34", 1};
+    auto Memory = MakeMemory(Data);
+    HolderT Holder{&Data.Header};
+    CHECK(!Holder.GetString()->IsValidTime(Memory));
+
+    HolderT Empty{nullptr};
+    CHECK(!Empty.GetString()->IsValidTime(Memory));
+
+    // The text lies outside the readable block
+    //
+    TextDataT Moved{L"12:34", 1};
+    HolderT Unreadable{&Moved.Header};
+    CHECK(!Unreadable.GetString()->IsValidTime(Memory));
+}
@@ -0,0 +1,184 @@
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Harness.h"
+#include "ReadableMemory.h"
+
+using namespace std::chrono_literals;
+
+// Stands in for `VirtualQuery()`, with regions that can be mapped and unmapped at any time. Counts
+// the queries, so the tests can tell what was answered from the cache.
+//
+class FakeMemory
+{
+public:
+    void Map(uintptr_t Begin, uintptr_t End)
+    {
+        std::lock_guard<std::mutex> Lock(_Mutex);
+        _Regions[Begin] = End;
+    }
+
+    void Unmap(uintptr_t Begin)
+    {
+        std::lock_guard<std::mutex> Lock(_Mutex);
+        _Regions.erase(Begin);
+    }
+
+    uint32_t GetQueryCount() const
+    {
+        return _QueryCount;
+    }
+
+    ReadableMemory::QueryT GetQuery()
+    {
+        return [this](uintptr_t Address) -> std::optional<ReadableMemory::RegionT> {
+            std::lock_guard<std::mutex> Lock(_Mutex);
+            ++_QueryCount;
+
+            auto Iterator = _Regions.upper_bound(Address);
+            if (Iterator == _Regions.begin() || Address >= std::prev(Iterator)->second) {
+                return std::nullopt;
+            }
+            --Iterator;
+            return ReadableMemory::RegionT{Iterator->first, Iterator->second};
+        };
+    }
+
+private:
+    std::mutex _Mutex;
+    std::map<uintptr_t, uintptr_t> _Regions;
+    std::atomic<uint32_t> _QueryCount = 0;
+};
+
+static const void *At(uintptr_t Address)
+{
+    return (const void *)Address;
+}
+
+TEST_CASE(ReadableMemory, Lookup)
+{
+    FakeMemory Memory;
+    Memory.Map(0x10000, 0x20000);
+    ReadableMemory Readable{Memory.GetQuery(), 1h};
+
+    CHECK(Readable.IsReadable(At(0x10000), 0x10));
+    CHECK(Readable.IsReadable(At(0x1FFF0), 0x10));
+    CHECK(Readable.IsReadable(At(0x18000), 0));
+    CHECK(!Readable.IsReadable(At(0x1FFF0), 0x11));
+    CHECK(!Readable.IsReadable(At(0xFFFF), 0x10));
+    CHECK(!Readable.IsReadable(At(0x20000), 1));
+
+    CHECK(!Readable.IsReadable(nullptr, 1));
+    CHECK(!Readable.IsReadable(At(UINTPTR_MAX - 4), 0x10));
+}
+
+TEST_CASE(ReadableMemory, Cached)
+{
+    FakeMemory Memory;
+    Memory.Map(0x10000, 0x20000);
+    ReadableMemory Readable{Memory.GetQuery(), 1h};
+
+    CHECK(Readable.IsReadable(At(0x10000), 8));
+    const auto QueryCount = Memory.GetQueryCount();
+
+    for (uintptr_t Address = 0x10000; Address < 0x20000; Address += 0x100) {
+        CHECK(Readable.IsReadable(At(Address), 8));
+    }
+    CHECK(Memory.GetQueryCount() == QueryCount);
+
+    // Unreadable addresses are asked again every time
+    //
+    CHECK(!Readable.IsReadable(At(0x30000), 8));
+    CHECK(!Readable.IsReadable(At(0x30000), 8));
+    CHECK(Memory.GetQueryCount() == QueryCount + 2);
+
+    Memory.Map(0x30000, 0x31000);
+    CHECK(Readable.IsReadable(At(0x30000), 8));
+}
+
+TEST_CASE(ReadableMemory, AdjacentRegions)
+{
+    FakeMemory Memory;
+    Memory.Map(0x10000, 0x11000);
+    Memory.Map(0x11000, 0x12000);
+    Memory.Map(0x13000, 0x14000);
+    ReadableMemory Readable{Memory.GetQuery(), 1h};
+
+    CHECK(Readable.IsReadable(At(0x10FF0), 0x20));
+    CHECK(Readable.IsReadable(At(0x10000), 0x2000));
+    CHECK(!Readable.IsReadable(At(0x11FF0), 0x20));
+    CHECK(!Readable.IsReadable(At(0x10000), 0x4000));
+}
+
+// A region freed since it was cached is trusted until it expires, then queried again.
+//
+TEST_CASE(ReadableMemory, Expiry)
+{
+    FakeMemory Memory;
+    Memory.Map(0x10000, 0x20000);
+    ReadableMemory Readable{Memory.GetQuery(), 50ms};
+
+    CHECK(Readable.IsReadable(At(0x10000), 8));
+    Memory.Unmap(0x10000);
+    CHECK(Readable.IsReadable(At(0x10000), 8));
+
+    std::this_thread::sleep_for(60ms);
+    CHECK(!Readable.IsReadable(At(0x10000), 8));
+}
+
+// A region queried again replaces the cached ones it overlaps, e.g. after the heap was released
+// and a larger block reserved over it.
+//
+TEST_CASE(ReadableMemory, Remapped)
+{
+    FakeMemory Memory;
+    Memory.Map(0x10000, 0x11000);
+    Memory.Map(0x12000, 0x13000);
+    ReadableMemory Readable{Memory.GetQuery(), 50ms};
+
+    CHECK(Readable.IsReadable(At(0x10000), 8));
+    CHECK(Readable.IsReadable(At(0x12000), 8));
+    CHECK(!Readable.IsReadable(At(0x11000), 8));
+
+    Memory.Unmap(0x10000);
+    Memory.Unmap(0x12000);
+    Memory.Map(0x10800, 0x12800);
+    std::this_thread::sleep_for(60ms);
+
+    CHECK(Readable.IsReadable(At(0x11000), 8));
+    CHECK(Readable.IsReadable(At(0x12000), 8));
+    CHECK(!Readable.IsReadable(At(0x10000), 8));
+    CHECK(!Readable.IsReadable(At(0x12800), 8));
+}
+
+TEST_CASE(ReadableMemory, ConcurrentLookups)
+{
+    FakeMemory Memory;
+    for (uintptr_t i = 0; i < 64; ++i) {
+        Memory.Map(0x100000 + i * 0x2000, 0x101000 + i * 0x2000);
+    }
+    ReadableMemory Readable{Memory.GetQuery(), 1ms};
+
+    std::atomic<uint32_t> Errors = 0;
+    std::vector<std::thread> Threads;
+    for (uint32_t i = 0; i < 8; ++i) {
+        Threads.emplace_back([&, i]() {
+            for (uintptr_t j = 0; j < 20000; ++j) {
+                const uintptr_t Base = 0x100000 + ((i + j) % 64) * 0x2000;
+                if (!Readable.IsReadable(At(Base + j % 0x1000), 1) ||
+                    Readable.IsReadable(At(Base + 0x1000 + j % 0x1000), 1))
+                {
+                    Errors.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (std::thread &Thread : Threads) {
+        Thread.join();
+    }
+
+    CHECK(Errors == 0);
+}
@@ -0,0 +1,133 @@
+#include <vector>
+#include <cstring>
+
+#include "Harness.h"
+#include "SyntheticMessage.h"
+
+// Publishes the layout of each generation of the embedded table, then reads synthetic objects
+// through the accessors of `Telegram.cpp`, the way the hooks read Telegram's.
+//
+
+// The version each generation is checked at, plus both sides of the `IsMessage()` switch
+//
+static std::vector<uint32_t> GetVersions()
+{
+    std::vector<uint32_t> Result;
+    for (const auto &Entry : Layouts::Embedded) {
+        Result.push_back(Entry.MinVersion);
+    }
+    Result.push_back(Layouts::IsServiceMinVersion - 1);
+    Result.push_back(Layouts::IsServiceMinVersion);
+    Result.push_back(UINT32_MAX);
+    return Result;
+}
+
+TEST_CASE(ResolvedLayout, Publish)
+{
+    const auto Layout = SyntheticMessage::MakeLayout(*SyntheticMessage::FindEntry(0), 0);
+
+    ResolvedLayout::Publish(&Layout);
+    CHECK(ResolvedLayout::Get() == &Layout);
+
+    ResolvedLayout::Publish(nullptr);
+    CHECK(ResolvedLayout::Get() == nullptr);
+}
+
+TEST_CASE(ResolvedLayout, SelectIsMessage)
+{
+    // Below 3.2.5 `toHistoryMessage()` is asked, from then on `isService()`
+    //
+    for (const uint32_t Version : GetVersions()) {
+        const auto pEntry = SyntheticMessage::FindEntry(Version);
+        if (pEntry == nullptr) {
+            continue;
+        }
+
+        const auto Layout = SyntheticMessage::MakeLayout(*pEntry, Version);
+        ResolvedLayout::Publish(&Layout);
+
+        const char *Expected =
+            Version < Layouts::IsServiceMinVersion ? "toHistoryMessage" : "isService";
+
+        SyntheticObject Message, Service;
+        SyntheticMessage::Init(Message, false);
+        SyntheticMessage::Init(Service, true);
+
+        SyntheticMessage::LastCall = nullptr;
+        CHECK(Message.As<HistoryMessage>()->IsMessage());
+        CHECK(SyntheticMessage::LastCall != nullptr &&
+              std::strcmp(SyntheticMessage::LastCall, Expected) == 0);
+
+        SyntheticMessage::LastCall = nullptr;
+        CHECK(!Service.As<HistoryMessage>()->IsMessage());
+        CHECK(SyntheticMessage::LastCall != nullptr &&
+              std::strcmp(SyntheticMessage::LastCall, Expected) == 0);
+    }
+
+    CHECK(ResolvedLayout::SelectIsMessage(0) ==
+          ResolvedLayout::SelectIsMessage(Layouts::IsServiceMinVersion - 1));
+    CHECK(ResolvedLayout::SelectIsMessage(Layouts::IsServiceMinVersion) ==
+          ResolvedLayout::SelectIsMessage(UINT32_MAX));
+    CHECK(ResolvedLayout::SelectIsMessage(Layouts::IsServiceMinVersion - 1) !=
+          ResolvedLayout::SelectIsMessage(Layouts::IsServiceMinVersion));
+
+    ResolvedLayout::Publish(nullptr);
+}
+
+TEST_CASE(ResolvedLayout, Accessors)
+{
+    // Every field gets a value of its own, so an accessor reading at the wrong offset reads
+    // another field's value or zero
+    //
+    for (const auto &Entry : Layouts::Embedded) {
+        const auto Layout = SyntheticMessage::MakeLayout(Entry, Entry.MinVersion);
+        const auto &Offset = Layout.Offset;
+        ResolvedLayout::Publish(&Layout);
+
+        for (const uint32_t FieldOffset :
+             {Offset.TimeText, Offset.TimeWidth, Offset.MainView, Offset.EditedTimeText,
+              Offset.SignedTimeText, Offset.MaxReplyWidth, Offset.ElementMedia})
+        {
+            CHECK(FieldOffset >= sizeof(void *));
+            CHECK(FieldOffset + sizeof(void *) <= SyntheticObject::Size);
+        }
+
+        SyntheticObject Message, MainView, Edited, Signed, Reply;
+        SyntheticMessage::Init(Message, false);
+
+        const auto pTimeTextData = (QtArrayData *)(uintptr_t)(Entry.MinVersion + 0x1000);
+        const auto pMedia = (Media *)(uintptr_t)(Entry.MinVersion + 0x2000);
+        const auto pEditedData = (QtArrayData *)(uintptr_t)(Entry.MinVersion + 0x3000);
+        const auto pSignedData = (QtArrayData *)(uintptr_t)(Entry.MinVersion + 0x4000);
+
+        Message.Write(Offset.TimeText, pTimeTextData);
+        Message.Write(Offset.TimeWidth, (int32_t)123);
+        Message.Write(Offset.MainView, MainView.As<HistoryViewElement>());
+        MainView.Write(Offset.ElementMedia, pMedia);
+        Edited.Write(Offset.EditedTimeText, pEditedData);
+        Signed.Write(Offset.SignedTimeText, pSignedData);
+        Reply.Write(Offset.MaxReplyWidth, (int32_t)456);
+
+        auto pMessage = Message.As<HistoryMessage>();
+        CHECK(pMessage->IsMessage());
+        CHECK(pMessage->GetTimeText()->GetData() == pTimeTextData);
+        CHECK(pMessage->GetTimeWidth() == 123);
+        CHECK(pMessage->GetMainView() == MainView.As<HistoryViewElement>());
+        CHECK(pMessage->GetMainView()->GetMedia() == pMedia);
+
+        CHECK(Edited.As<HistoryMessageEdited>()->GetTimeText()->GetData() == pEditedData);
+        CHECK(Signed.As<HistoryMessageSigned>()->GetTimeText()->GetData() == pSignedData);
+        CHECK(Reply.As<HistoryMessageReply>()->MaxReplyWidth() == 456);
+
+        // Writes land on the same fields
+        //
+        pMessage->SetTimeWidth(789);
+        CHECK(Message.Read<int32_t>(Offset.TimeWidth) == 789);
+        CHECK(Message.Read<QtArrayData *>(Offset.TimeText) == pTimeTextData);
+
+        Reply.As<HistoryMessageReply>()->MaxReplyWidth() = 1011;
+        CHECK(Reply.Read<int32_t>(Offset.MaxReplyWidth) == 1011);
+    }
+
+    ResolvedLayout::Publish(nullptr);
+}
@@ -0,0 +1,95 @@
+#include <thread>
+
+#include "Harness.h"
+#include "SyntheticCode.h"
+#include "Signatures.h"
+
+// About the size of the code section of Telegram.exe
+//
+constexpr size_t ImageSize = 0x6000000;
+
+static const std::vector<std::byte> &GetImage()
+{
+    static const auto Image = MakeSyntheticCode(ImageSize);
+    return Image;
+}
+
+// Each signature searched over the whole image, by the vectorized kernel the CPU supports and by
+// checking every position in turn like the search it replaced. Then all of them at once.
+//
+BENCHMARK(SigScanner, Throughput)
+{
+    const auto &Image = GetImage();
+    const double Gigabytes = (double)Image.size() / 1e9;
+
+    std::printf(
+        "  %-24s %14s %14s %10s\n", "signature", "each (GB/s)", "scanner (GB/s)", "matches");
+
+    double TotalEachTime = 0;
+    for (const auto &[Name, Pattern, IsCritical] : Signatures::All) {
+        size_t Matches = 0;
+        const double EachTime = Harness::MeasureBest(3, [&]() {
+            Matches = FindByEachPosition(Image.data(), Image.size(), Pattern).size();
+        });
+        const double ScannerTime = Harness::MeasureBest(3, [&]() {
+            SigScanner Scanner;
+            Scanner.Add(Pattern);
+            Scanner.Scan(Image.data(), Image.size());
+            Harness::KeepAlive(Scanner);
+        });
+        TotalEachTime += EachTime;
+
+        std::printf(
+            "  %-24s %14.2f %14.2f %10zu\n", Name, Gigabytes / EachTime, Gigabytes / ScannerTime,
+            Matches);
+    }
+
+    const double SinglePassTime = Harness::MeasureBest(3, [&]() {
+        SigScanner Scanner;
+        for (const auto &[Name, Pattern, IsCritical] : Signatures::All) {
+            Scanner.Add(Pattern);
+        }
+        Scanner.Scan(Image.data(), Image.size());
+        Harness::KeepAlive(Scanner);
+    });
+
+    std::printf(
+        "  %-24s %14.2f %14.2f\n", "(all signatures)", Gigabytes / TotalEachTime,
+        Gigabytes / SinglePassTime);
+}
+
+// All signatures in one pass, split across 1 to N threads
+//
+BENCHMARK(SigScanner, ThreadScaling)
+{
+    const auto &Image = GetImage();
+    const double Gigabytes = (double)Image.size() / 1e9;
+
+    const uint32_t MaxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<uint32_t> ThreadCounts;
+    for (uint32_t ThreadCount = 1; ThreadCount < MaxThreads; ThreadCount *= 2) {
+        ThreadCounts.push_back(ThreadCount);
+    }
+    ThreadCounts.push_back(MaxThreads);
+
+    std::printf("  %8s %12s %12s %10s\n", "threads", "time (ms)", "GB/s", "speedup");
+
+    double SingleTime = 0;
+    for (uint32_t ThreadCount : ThreadCounts) {
+        const double Time = Harness::MeasureBest(3, [&]() {
+            SigScanner Scanner;
+            for (const auto &[Name, Pattern, IsCritical] : Signatures::All) {
+                Scanner.Add(Pattern);
+            }
+            Scanner.Scan(Image.data(), Image.size(), ThreadCount);
+            Harness::KeepAlive(Scanner);
+        });
+
+        if (ThreadCount == 1) {
+            SingleTime = Time;
+        }
+        std::printf(
+            "  %8u %12.1f %12.2f %9.2fx\n", ThreadCount, Time * 1e3, Gigabytes / Time,
+            SingleTime / Time);
+    }
+}
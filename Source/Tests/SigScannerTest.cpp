@@ -0,0 +1,187 @@
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+#include "Harness.h"
+#include "SyntheticCode.h"
+#include "SyntheticPe.h"
+#include "Signatures.h"
+
+TEST_CASE(SigScanner, Parse)
+{
+    auto Sig = Signature::Parse("41 84 ?? 75 ? 2b");
+    CHECK(Sig.has_value());
+    CHECK(Sig->GetSize() == 6);
+    CHECK(Sig->GetByte(0) == 0x41 && Sig->GetByte(5) == 0x2B);
+    CHECK(Sig->IsWildcard(2) && Sig->IsWildcard(4) && !Sig->IsWildcard(3));
+
+    // The rarest fixed bytes, the second one at another position
+    //
+    auto Anchored = Signature::Parse("8B 48 ?? 89 E8 ?? 2B");
+    CHECK(Anchored->GetAnchor() == 6);
+    CHECK(Anchored->GetSecondAnchor() == 4);
+
+    CHECK(Signature::Parse("E8")->GetAnchor() == Signature::Parse("E8")->GetSecondAnchor());
+
+    CHECK(!Signature::Parse("").has_value());
+    CHECK(!Signature::Parse("?? ??").has_value());
+    CHECK(!Signature::Parse("4").has_value());
+    CHECK(!Signature::Parse("123").has_value());
+    CHECK(!Signature::Parse("GG").has_value());
+}
+
+TEST_CASE(SigScanner, AddTwice)
+{
+    SigScanner Scanner;
+    CHECK(Scanner.Add("41 84 C0"));
+    CHECK(Scanner.Add("41 84 C0"));
+    CHECK(!Scanner.Add("41 8"));
+    CHECK(Scanner.Contains("41 84 C0"));
+    CHECK(!Scanner.Contains("41 8"));
+
+    const std::byte Data[] = {std::byte{0x41}, std::byte{0x84}, std::byte{0xC0}};
+    Scanner.Scan(Data, sizeof(Data));
+    CHECK(Scanner.GetMatches("41 84 C0").size() == 1);
+    CHECK(Scanner.GetMatches("CC").empty());
+}
+
+// All signatures of the plugin in a single pass over a synthetic image, planted across the
+// block and chunk boundaries of the scanner and at the very end, must find exactly what checking
+// every position does.
+//
+TEST_CASE(SigScanner, SyntheticImage)
+{
+    constexpr size_t Size = 0x280000;
+    auto Image = MakeSyntheticCode(Size);
+
+    size_t Offset = 0;
+    for (const auto &[Name, Pattern, IsCritical] : Signatures::All) {
+        const size_t Length = Signature::Parse(Pattern)->GetSize();
+
+        PlantSignature(Image, Offset + 0x1234, Pattern);
+        PlantSignature(Image, 0x10000 * (Offset / 0x40 + 1) - Length / 2, Pattern);
+        PlantSignature(Image, 0x100000 - 1 - Offset, Pattern);
+        Offset += 0x40;
+    }
+    const size_t LastOffset = Size - Signature::Parse(Signatures::Malloc)->GetSize();
+    PlantSignature(Image, LastOffset, Signatures::Malloc);
+
+    SigScanner Scanner;
+    for (const auto &[Name, Pattern, IsCritical] : Signatures::All) {
+        CHECK(Scanner.Add(Pattern));
+    }
+    Scanner.Scan(Image.data(), Image.size());
+
+    for (const auto &[Name, Pattern, IsCritical] : Signatures::All) {
+        const auto Expected = FindByEachPosition(Image.data(), Image.size(), Pattern);
+        CHECK(Expected.size() >= 3);
+        CHECK(Scanner.GetMatches(Pattern) == Expected);
+        CHECK(Scanner.GetCandidateCount(Pattern) >= Expected.size());
+    }
+    CHECK(Scanner.GetMatches(Signatures::Malloc).back() == Image.data() + LastOffset);
+}
+
+// Scans append, so a module split into several regions can be scanned region by region.
+//
+TEST_CASE(SigScanner, SeveralRegions)
+{
+    auto Image = MakeSyntheticCode(0x30000);
+    PlantSignature(Image, 0x100, "0F 0B ?? 0F 0B");
+    PlantSignature(Image, 0x20100, "0F 0B ?? 0F 0B");
+
+    SigScanner Scanner;
+    Scanner.Add("0F 0B ?? 0F 0B");
+    Scanner.Scan(Image.data(), 0x10000);
+    Scanner.Scan(Image.data() + 0x20000, 0x10000);
+
+    const auto &Matches = Scanner.GetMatches("0F 0B ?? 0F 0B");
+    CHECK(Matches.size() == 2);
+    CHECK(Matches.size() == 2 && Matches[0] == Image.data() + 0x100);
+    CHECK(Matches.size() == 2 && Matches[1] == Image.data() + 0x20100);
+}
+
+// The same as `IRuntime` does on Telegram.exe: a PE file read back from disk, only its code
+// section scanned. The copy of the signature in ".rdata" must not be found.
+//
+TEST_CASE(SigScanner, PeFileOnDisk)
+{
+    auto Code = MakeSyntheticCode(0x30000, 1);
+    auto ReadOnly = MakeSyntheticCode(0x8000, 2);
+    PlantSignature(Code, 0x12345, Signatures::DestroyMessage);
+    PlantSignature(ReadOnly, 0x100, Signatures::DestroyMessage);
+
+    const auto Pe = SyntheticPe::Build(
+        {}, {{".text", 0x1000, 0x30000, SyntheticPe::SectionCode, Code},
+             {".rdata", 0x31000, 0x8000, SyntheticPe::SectionRData, ReadOnly}},
+        PeImage::Layout::File);
+
+    const auto Path = std::filesystem::temp_directory_path() / "TAR-SigScannerTest.exe";
+    {
+        std::ofstream Output{Path, std::ios::binary | std::ios::trunc};
+        Output.write((const char *)Pe.data(), Pe.size());
+        CHECK(Output.good());
+    }
+
+    std::ifstream Input{Path, std::ios::binary};
+    std::vector<char> File{std::istreambuf_iterator<char>{Input}, {}};
+    Input.close();
+    std::filesystem::remove(Path);
+
+    auto Image = PeImage::Parse((const std::byte *)File.data(), File.size(), PeImage::Layout::File);
+    CHECK(Image.has_value());
+    if (!Image.has_value()) {
+        return;
+    }
+
+    const auto pText = Image->FindSection(".text");
+    CHECK(pText != nullptr);
+    if (pText == nullptr) {
+        return;
+    }
+
+    SigScanner Scanner;
+    Scanner.Add(Signatures::DestroyMessage);
+    Scanner.Scan(Image->GetSectionBegin(*pText), Image->GetSectionSize(*pText));
+
+    const auto &Matches = Scanner.GetMatches(Signatures::DestroyMessage);
+    CHECK(Matches.size() == 1);
+    CHECK(Matches.size() == 1 && Image->IsInSections(Matches[0], {".text"}));
+    CHECK(Matches.size() == 1 && Matches[0] == Image->GetPointer(0x1000 + 0x12345));
+}
+
+// Chunks scanned concurrently are merged in order, so the matches don't depend on the number of
+// threads, and the uniqueness checks of `IRuntime` hold either way.
+//
+TEST_CASE(SigScanner, ThreadCountIndependent)
+{
+    constexpr size_t Size = 0x4A0000;
+    auto Image = MakeSyntheticCode(Size, 3);
+
+    for (size_t Offset = 0xFFFF0; Offset < Size; Offset += 0x100000) {
+        PlantSignature(Image, Offset, Signatures::EditedIndex);
+        PlantSignature(Image, Offset + 0x8000, Signatures::ReplyIndex);
+    }
+
+    auto ScanWith = [&](uint32_t ThreadCount) {
+        SigScanner Scanner;
+        for (const auto &[Name, Pattern, IsCritical] : Signatures::All) {
+            Scanner.Add(Pattern);
+        }
+        Scanner.Scan(Image.data(), Image.size(), ThreadCount);
+        return Scanner;
+    };
+
+    const auto Single = ScanWith(1);
+    for (uint32_t ThreadCount : {2, 3, 8, 64}) {
+        const auto Threaded = ScanWith(ThreadCount);
+        for (const auto &[Name, Pattern, IsCritical] : Signatures::All) {
+            CHECK(Threaded.GetMatches(Pattern) == Single.GetMatches(Pattern));
+            CHECK(Threaded.GetCandidateCount(Pattern) == Single.GetCandidateCount(Pattern));
+        }
+    }
+
+    CHECK(Single.GetMatches(Signatures::EditedIndex).size() >= 4);
+    CHECK(
+        Single.GetMatches(Signatures::EditedIndex) ==
+        FindByEachPosition(Image.data(), Image.size(), Signatures::EditedIndex));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string_view>
+
+#include "SigScanner.h"
+
+// Pseudo-random bytes with roughly the byte frequencies of x86/x64 code, so the anchor prefilter
+// of `SigScanner` sees about as many candidates as it does on Telegram.exe. The same seed always
+// gives the same bytes.
+//
+inline std::vector<std::byte> MakeSyntheticCode(size_t Size, uint64_t Seed = 0x9E3779B97F4A7C15)
+{
+    constexpr uint8_t Frequent[] = {0x00, 0xFF, 0x8B, 0x48, 0x89, 0xCC, 0x0F, 0x24,
+                                    0x44, 0x4C, 0x85, 0xE8, 0x83, 0x01, 0x8D, 0xC0};
+
+    std::vector<std::byte> Result(Size);
+    uint64_t State = Seed;
+    for (size_t i = 0; i < Size; ++i) {
+        // xorshift64
+        //
+        State ^= State << 13;
+        State ^= State >> 7;
+        State ^= State << 17;
+
+        const auto Random = (uint8_t)(State >> 32);
+        Result[i] = (std::byte)((State & 1) != 0 ? Frequent[Random % std::size(Frequent)] : Random);
+    }
+    return Result;
+}
+
+// Writes the fixed bytes of `Pattern` at `Offset`, wildcards keep what was there.
+//
+inline void PlantSignature(std::vector<std::byte> &Image, size_t Offset, std::string_view Pattern)
+{
+    const auto Sig = Signature::Parse(Pattern).value();
+    for (size_t i = 0; i < Sig.GetSize(); ++i) {
+        if (!Sig.IsWildcard(i)) {
+            Image[Offset + i] = (std::byte)Sig.GetByte(i);
+        }
+    }
+}
+
+// Every position the signature matches at, by checking each of them in turn.
+//
+inline SigScanner::MatchesT
+FindByEachPosition(const std::byte *Begin, size_t Size, std::string_view Pattern)
+{
+    const auto Sig = Signature::Parse(Pattern).value();
+
+    SigScanner::MatchesT Result;
+    for (size_t Pos = 0; Sig.GetSize() <= Size && Pos <= Size - Sig.GetSize(); ++Pos) {
+        if (Sig.IsMatch(Begin + Pos)) {
+            Result.push_back(Begin + Pos);
+        }
+    }
+    return Result;
+}
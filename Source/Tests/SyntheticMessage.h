@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#include "Layouts.h"
+#include "ResolvedLayout.h"
+#include "Telegram.h"
+
+// Stands in for a Telegram object, read through the `Telegram.cpp` accessors. Fields are planted
+// at the offsets of a layout, and a message gets a virtual table whose `toHistoryMessage()` and
+// `isService()` tell it apart from a service message.
+//
+class SyntheticObject
+{
+public:
+    static constexpr uint32_t Size = 0x200;
+
+    template <class T>
+    T *As()
+    {
+        return (T *)_Data;
+    }
+
+    template <class T>
+    void Write(uint32_t Offset, T Value)
+    {
+        std::memcpy(_Data + Offset, &Value, sizeof(T));
+    }
+
+    template <class T>
+    T Read(uint32_t Offset) const
+    {
+        T Value;
+        std::memcpy(&Value, _Data + Offset, sizeof(T));
+        return Value;
+    }
+
+private:
+    alignas(void *) std::byte _Data[Size] = {};
+};
+
+namespace SyntheticMessage {
+
+// Virtual call indexes, as `IRuntime` would resolve them for each version
+//
+constexpr uint32_t ToHistoryMessageIndex = 3;
+constexpr uint32_t IsServiceIndex = 7;
+
+// The name of the virtual function a synthetic message was last asked through
+//
+inline const char *LastCall = nullptr;
+
+template <bool IsService>
+HistoryMessage *ToHistoryMessage(HistoryMessage *This)
+{
+    LastCall = "toHistoryMessage";
+    return IsService ? nullptr : This;
+}
+
+template <bool IsService>
+bool IsServiceItem(HistoryMessage *This)
+{
+    LastCall = "isService";
+    return IsService;
+}
+
+// Slots other than the two above are left null, so calling one of them crashes.
+//
+template <bool IsService>
+const std::array<void *, 8> VirtualTable = {
+    nullptr, nullptr, nullptr, (void *)&ToHistoryMessage<IsService>,
+    nullptr, nullptr, nullptr, (void *)&IsServiceItem<IsService>,
+};
+
+// A message, or a service message, with its virtual table in place.
+//
+inline void Init(SyntheticObject &Object, bool IsService)
+{
+    Object.Write(0, IsService ? VirtualTable<true>.data() : VirtualTable<false>.data());
+}
+
+// The entry of the embedded table applying to `Version`, nullptr if it is not supported.
+//
+inline const Layouts::EntryT *FindEntry(uint32_t Version)
+{
+    return Layouts::FindEntry(std::begin(Layouts::Embedded), std::end(Layouts::Embedded), Version);
+}
+
+// The layout `IRuntime::PublishLayout()` builds from `Entry` for `Version`. The component indexes
+// are not read by the accessors and left zero.
+//
+inline ResolvedLayoutT MakeLayout(const Layouts::EntryT &Entry, uint32_t Version)
+{
+    ResolvedLayoutT Layout = {};
+    Layout.Offset = Entry.Offset;
+    Layout.Index.IsService =
+        Version < Layouts::IsServiceMinVersion ? ToHistoryMessageIndex : IsServiceIndex;
+    Layout.FnIsMessage = ResolvedLayout::SelectIsMessage(Version);
+    return Layout;
+}
+
+} // namespace SyntheticMessage
@@ -0,0 +1,142 @@
+#include "SyntheticPe.h"
+
+#include <map>
+#include <cstring>
+#include <algorithm>
+
+namespace SyntheticPe {
+
+template <class T>
+static void WriteAt(std::vector<std::byte> &Buffer, size_t Offset, T Value)
+{
+    std::memcpy(Buffer.data() + Offset, &Value, sizeof(T));
+}
+
+static uint32_t AlignUp(uint32_t Value, uint32_t Alignment)
+{
+    return (Value + Alignment - 1) / Alignment * Alignment;
+}
+
+// IMAGE_BASE_RELOCATION blocks, one per page
+//
+static std::vector<std::byte> BuildRelocations(const std::vector<uint32_t> &Rvas, bool Is64Bit)
+{
+    const uint16_t Type = Is64Bit ? 10 /* DIR64 */ : 3 /* HIGHLOW */;
+
+    std::map<uint32_t, std::vector<uint16_t>> Pages;
+    for (uint32_t Rva : Rvas) {
+        Pages[Rva & ~0xFFFu].push_back((uint16_t)(Type << 12 | (Rva & 0xFFF)));
+    }
+
+    std::vector<std::byte> Result;
+    for (auto &[PageRva, Entries] : Pages) {
+        // Blocks are 4-byte aligned, padded with an absolute entry
+        //
+        if (Entries.size() % 2 != 0) {
+            Entries.push_back(0);
+        }
+
+        const size_t Offset = Result.size();
+        const uint32_t BlockSize = (uint32_t)(8 + Entries.size() * 2);
+        Result.resize(Offset + BlockSize);
+        WriteAt(Result, Offset, PageRva);
+        WriteAt(Result, Offset + 4, BlockSize);
+        std::memcpy(Result.data() + Offset + 8, Entries.data(), Entries.size() * 2);
+    }
+    return Result;
+}
+
+std::vector<std::byte> Build(
+    const OptionsT &Options, std::vector<SyntheticSectionT> Sections, PeImage::Layout Layout)
+{
+    uint32_t RelocRva = 0, RelocSize = 0;
+    if (!Options.Relocations.empty()) {
+        uint32_t End = SectionAlignment;
+        for (const auto &Section : Sections) {
+            End = std::max(End, AlignUp(Section.VirtualAddress + Section.VirtualSize, 0x1000));
+        }
+
+        auto Data = BuildRelocations(Options.Relocations, Options.Is64Bit);
+        RelocRva = End;
+        RelocSize = (uint32_t)Data.size();
+        Sections.push_back({".reloc", RelocRva, RelocSize, SectionRData, std::move(Data)});
+    }
+
+    uint32_t SizeOfImage = SizeOfHeaders;
+    for (const auto &Section : Sections) {
+        SizeOfImage = std::max(
+            SizeOfImage, AlignUp(Section.VirtualAddress + Section.VirtualSize, SectionAlignment));
+    }
+
+    // Raw data follows the headers in section order
+    //
+    std::vector<uint32_t> PointersToRawData;
+    uint32_t FileSize = SizeOfHeaders;
+    for (const auto &Section : Sections) {
+        PointersToRawData.push_back(FileSize);
+        FileSize += AlignUp((uint32_t)Section.Data.size(), FileAlignment);
+    }
+
+    std::vector<std::byte> Result(Layout == PeImage::Layout::File ? FileSize : SizeOfImage);
+
+    // IMAGE_DOS_HEADER
+    //
+    constexpr uint32_t NtOffset = 0x80;
+    WriteAt<uint16_t>(Result, 0, 0x5A4D);
+    WriteAt<uint32_t>(Result, 0x3C, NtOffset);
+
+    // IMAGE_NT_HEADERS
+    //
+    const uint16_t SizeOfOptionalHeader = Options.Is64Bit ? 0xF0 : 0xE0;
+    const size_t FileHeader = NtOffset + 4, OptionalHeader = FileHeader + 20;
+
+    WriteAt<uint32_t>(Result, NtOffset, 0x00004550);
+    WriteAt<uint16_t>(Result, FileHeader, Options.Is64Bit ? 0x8664 : 0x14C);
+    WriteAt<uint16_t>(Result, FileHeader + 2, (uint16_t)Sections.size());
+    WriteAt<uint32_t>(Result, FileHeader + 4, Options.TimeDateStamp);
+    WriteAt<uint16_t>(Result, FileHeader + 16, SizeOfOptionalHeader);
+
+    size_t DataDirectories;
+    if (Options.Is64Bit) {
+        WriteAt<uint16_t>(Result, OptionalHeader, 0x20B);
+        WriteAt<uint64_t>(Result, OptionalHeader + 24, Options.ImageBase);
+        DataDirectories = OptionalHeader + 108;
+    }
+    else {
+        WriteAt<uint16_t>(Result, OptionalHeader, 0x10B);
+        WriteAt<uint32_t>(Result, OptionalHeader + 28, (uint32_t)Options.ImageBase);
+        DataDirectories = OptionalHeader + 92;
+    }
+    WriteAt<uint32_t>(Result, OptionalHeader + 32, SectionAlignment);
+    WriteAt<uint32_t>(Result, OptionalHeader + 36, FileAlignment);
+    WriteAt<uint32_t>(Result, OptionalHeader + 56, SizeOfImage);
+    WriteAt<uint32_t>(Result, OptionalHeader + 60, SizeOfHeaders);
+    WriteAt<uint32_t>(Result, DataDirectories, 16);
+    WriteAt<uint32_t>(Result, DataDirectories + 4 + PeImage::DirectoryBaseReloc * 8, RelocRva);
+    WriteAt<uint32_t>(Result, DataDirectories + 8 + PeImage::DirectoryBaseReloc * 8, RelocSize);
+
+    // IMAGE_SECTION_HEADER
+    //
+    const size_t SectionTable = OptionalHeader + SizeOfOptionalHeader;
+    for (size_t i = 0; i < Sections.size(); ++i) {
+        const auto &Section = Sections[i];
+        const size_t Header = SectionTable + i * 40;
+        const uint32_t SizeOfRawData = AlignUp((uint32_t)Section.Data.size(), FileAlignment);
+
+        std::memcpy(
+            Result.data() + Header, Section.Name.data(), std::min<size_t>(Section.Name.size(), 8));
+        WriteAt<uint32_t>(Result, Header + 8, Section.VirtualSize);
+        WriteAt<uint32_t>(Result, Header + 12, Section.VirtualAddress);
+        WriteAt<uint32_t>(Result, Header + 16, SizeOfRawData);
+        WriteAt<uint32_t>(Result, Header + 20, PointersToRawData[i]);
+        WriteAt<uint32_t>(Result, Header + 36, Section.Characteristics);
+
+        const size_t Offset =
+            Layout == PeImage::Layout::File ? PointersToRawData[i] : Section.VirtualAddress;
+        std::memcpy(Result.data() + Offset, Section.Data.data(), Section.Data.size());
+    }
+
+    return Result;
+}
+
+} // namespace SyntheticPe
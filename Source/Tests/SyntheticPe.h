@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PeImage.h"
+
+// Builds small PE images in memory, laid out either as a file on disk or as a module loaded by
+// the system, for the tests of `PeImage` and of the scans over it.
+//
+struct SyntheticSectionT
+{
+    std::string Name;
+    uint32_t VirtualAddress; // Must be aligned to `SyntheticPe::SectionAlignment`
+    uint32_t VirtualSize;    // Larger than `Data` for uninitialized data
+    uint32_t Characteristics;
+    std::vector<std::byte> Data;
+};
+
+namespace SyntheticPe {
+
+constexpr uint32_t SectionAlignment = 0x1000;
+constexpr uint32_t FileAlignment = 0x200;
+constexpr uint32_t SizeOfHeaders = 0x400;
+
+constexpr uint32_t SectionCode = 0x60000020;  // IMAGE_SCN_CNT_CODE | MEM_EXECUTE | MEM_READ
+constexpr uint32_t SectionData = 0xC0000040;  // INITIALIZED_DATA | MEM_READ | MEM_WRITE
+constexpr uint32_t SectionRData = 0x40000040; // INITIALIZED_DATA | MEM_READ
+
+struct OptionsT
+{
+    bool Is64Bit = true;
+    uint64_t ImageBase = 0x140000000;
+    uint32_t TimeDateStamp = 0x60000000;
+
+    // RVAs of pointer-sized fixups, written into a ".reloc" section placed after the others
+    //
+    std::vector<uint32_t> Relocations;
+};
+
+std::vector<std::byte> Build(
+    const OptionsT &Options, std::vector<SyntheticSectionT> Sections, PeImage::Layout Layout);
+
+} // namespace SyntheticPe
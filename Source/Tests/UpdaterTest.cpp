@@ -0,0 +1,164 @@
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "Harness.h"
+#include "Config.h"
+#include "IUpdater.h"
+
+#pragma comment(lib, "Ws2_32.lib")
+
+using namespace std::chrono_literals;
+
+// Stands in for the bridge and GitHub on a loopback port. Each request is answered with the
+// latest release only after `Delay`, like a slow network would.
+//
+class StandInServer
+{
+public:
+    StandInServer(std::chrono::milliseconds Delay, std::string Body)
+        : _Delay{Delay}, _Body{std::move(Body)}
+    {
+        WSADATA Data;
+        WSAStartup(MAKEWORD(2, 2), &Data);
+
+        _Listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+        sockaddr_in Address{};
+        Address.sin_family = AF_INET;
+        Address.sin_port = 0;
+        inet_pton(AF_INET, "127.0.0.1", &Address.sin_addr);
+
+        int AddressSize = sizeof(Address);
+        bind(_Listener, (const sockaddr *)&Address, sizeof(Address));
+        getsockname(_Listener, (sockaddr *)&Address, &AddressSize);
+        listen(_Listener, SOMAXCONN);
+        _Port = ntohs(Address.sin_port);
+
+        _Thread = std::thread{[this]() { Run(); }};
+    }
+
+    ~StandInServer()
+    {
+        closesocket(_Listener);
+        _Thread.join();
+        WSACleanup();
+    }
+
+    Internet::ServerT GetServer() const
+    {
+        return {"127.0.0.1", _Port, false};
+    }
+
+    uint32_t GetReplyCount() const
+    {
+        return _ReplyCount;
+    }
+
+private:
+    std::chrono::milliseconds _Delay;
+    std::string _Body;
+    SOCKET _Listener;
+    uint16_t _Port;
+    std::thread _Thread;
+    std::atomic<uint32_t> _ReplyCount = 0;
+
+    // Ends once the listener is closed
+    //
+    void Run()
+    {
+        SOCKET Client;
+        while ((Client = accept(_Listener, nullptr, nullptr)) != INVALID_SOCKET) {
+            std::string Request;
+            char Buffer[0x1000];
+            int Received;
+            while (Request.find("\r\n\r\n") == std::string::npos &&
+                   (Received = recv(Client, Buffer, sizeof(Buffer), 0)) > 0)
+            {
+                Request.append(Buffer, Received);
+            }
+
+            std::this_thread::sleep_for(_Delay);
+
+            const std::string Response = "HTTP/1.1 200 OK\r\n"
+                                         "Content-Type: application/json\r\n"
+                                         "Content-Length: " +
+                                         std::to_string(_Body.size()) +
+                                         "\r\n"
+                                         "Connection: close\r\n"
+                                         "\r\n" +
+                                         _Body;
+            send(Client, Response.data(), (int)Response.size(), 0);
+            shutdown(Client, SD_SEND);
+            closesocket(Client);
+            ++_ReplyCount;
+        }
+    }
+};
+
+// A release older than any build, so no update prompt pops up
+//
+static const std::string LatestRelease = "{\"tag_name\": \"0.0.0\", \"html_url\": \"" AR_REPO_URL
+                                         "/releases/tag/0.0.0\", \"body\": \"\"}";
+
+// The result arrives on the checking thread, which may outlive a failed case
+//
+static std::future<bool> CheckUpdateAsync(IUpdater &Updater)
+{
+    auto Result = std::make_shared<std::promise<bool>>();
+    Updater.CheckUpdateAsync([Result](bool IsSuccessful) { Result->set_value(IsSuccessful); });
+    return Result->get_future();
+}
+
+// `Initialize()` in `RealMain.cpp` sets up the hooks right after starting the check. That must not
+// wait for the server, which answers long after the check was started.
+//
+TEST_CASE(Updater, SlowNetwork)
+{
+    constexpr auto Delay = 2s;
+
+    StandInServer Server{Delay, LatestRelease};
+    auto &Updater = IUpdater::GetInstance();
+    Updater.SetServers(Server.GetServer(), Server.GetServer());
+
+    const auto Begin = std::chrono::steady_clock::now();
+    auto Future = CheckUpdateAsync(Updater);
+    const auto Returned = std::chrono::steady_clock::now() - Begin;
+
+    CHECK(Returned < 100ms);
+    CHECK(Server.GetReplyCount() == 0);
+
+    const bool IsReady = Future.wait_for(Delay + 10s) == std::future_status::ready;
+    CHECK(IsReady);
+    if (IsReady) {
+        CHECK(std::chrono::steady_clock::now() - Begin >= Delay);
+        CHECK(Future.get());
+        CHECK(Server.GetReplyCount() == 1);
+    }
+}
+
+// With both servers unreachable, the check still ends and reports the failure
+//
+TEST_CASE(Updater, Offline)
+{
+    uint16_t Port;
+    {
+        StandInServer Server{0ms, LatestRelease};
+        Port = Server.GetServer().Port;
+    }
+
+    auto &Updater = IUpdater::GetInstance();
+    Updater.SetServers({"127.0.0.1", Port, false}, {"127.0.0.1", Port, false});
+
+    auto Future = CheckUpdateAsync(Updater);
+
+    const bool IsReady = Future.wait_for(30s) == std::future_status::ready;
+    CHECK(IsReady);
+    CHECK(!IsReady || !Future.get());
+}